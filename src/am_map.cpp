@@ -50,6 +50,7 @@
 #include "wl_game.h"
 #include "wl_main.h"
 #include "wl_play.h"
+#include "wl_shade.h"
 
 AutoMap::Color &AutoMap::Color::operator=(int rgb)
 {
@@ -218,7 +219,7 @@ static const AMVectorPoint AM_Arrow[] =
 
 AutoMap::AutoMap(unsigned int flags) :
 	fullRefresh(true), amFlags(flags),
-	ampanx(0), ampany(0)
+	ampanx(0), ampany(0), layerShift(-1), layerWidth(0)
 {
 	amangle = 0;
 	minmaxSel = 0;
@@ -238,6 +239,7 @@ AutoMap::~AutoMap()
 void AutoMap::CalculateDimensions(unsigned int x, unsigned int y, unsigned int width, unsigned int height)
 {
 	fullRefresh = true;
+	layerShift = -1;
 	amsizex = width;
 	amsizey = height;
 	amx = x;
@@ -307,6 +309,42 @@ public:
 	FTextureID texid;
 	float shiftx, shifty;
 };
+
+// Largest width or height of the automap layer in pixels. Beyond this the
+// tiles are drawn as polygons, but only a handful of them will be on screen.
+static const unsigned int AM_MAXLAYERSIZE = 2048;
+
+void AutoMap::AddPushwall(MapSpot spot, unsigned int mx, unsigned int my, fixed ofsx, fixed ofsy, TArray<AMPWall> &pwalls) const
+{
+	TArray<FVector2> points;
+	fixed tx = (mx<<FRACBITS), ty = my<<FRACBITS;
+	switch(spot->pushDirection)
+	{
+		default:
+		case MapTile::East:
+			tx += (spot->pushAmount<<10);
+			break;
+		case MapTile::West:
+			tx -= (spot->pushAmount<<10);
+			break;
+		case MapTile::South:
+			ty += (spot->pushAmount<<10);
+			break;
+		case MapTile::North:
+			ty -= (spot->pushAmount<<10);
+			break;
+	}
+	if(TransformTile(spot, FixedMul(tx-ofsx, scale), FixedMul(ty-ofsy, scale), points))
+	{
+		AMPWall pwall;
+		pwall.points = points;
+		pwall.texid = spot->tile->overhead.isValid() ? spot->tile->overhead : spot->texture[0];
+		pwall.shiftx = (float)(FIXED2FLOAT(FixedMul(FixedMul(scale, tx&0xFFFF), amcos) - FixedMul(FixedMul(scale, ty&0xFFFF), amsin)));
+		pwall.shifty = (float)(FIXED2FLOAT(FixedMul(FixedMul(scale, tx&0xFFFF), amsin) + FixedMul(FixedMul(scale, ty&0xFFFF), amcos)));
+		pwalls.Push(pwall);
+	}
+}
+
 void AutoMap::Draw()
 {
 	TArray<AMPWall> pwalls;
@@ -347,105 +385,63 @@ void AutoMap::Draw()
 	const double originy = (amy+amsizey/2) - (FIXED2FLOAT(FixedMul(FixedMul(scale, ofsx&0xFFFF), amsin) + FixedMul(FixedMul(scale, ofsy&0xFFFF), amcos)));
 	const double origTexScale = FIXED2FLOAT(scale>>6);
 
-	for(unsigned int my = 0;my < mapheight;++my)
+	const int shift = GetLayerShift(mapwidth, mapheight);
+	if(shift >= 0)
 	{
-		MapSpot spot = map->GetSpot(0, my, 0);
-		for(unsigned int mx = 0;mx < mapwidth;++mx, ++spot)
+		// Zoomed out far enough that the pre-rendered layer has at least as
+		// much detail as the screen, so just resample it.
+		TArray<MapSpot> pushing;
+		UpdateLayer(mapwidth, mapheight, shift, pushing);
+		DrawLayer(mapwidth, mapheight, ofsx, ofsy);
+
+		for(unsigned int i = 0;i < pushing.Size();++i)
+			AddPushwall(pushing[i], pushing[i]->GetX(), pushing[i]->GetY(), ofsx, ofsy, pwalls);
+	}
+	else
+	{
+		// Find the range of tiles which can be on screen by transforming the
+		// corners of the automap area back into map space. Pushwalls may be
+		// up to a tile away from their spot so pad the range by one.
+		const double invscale = 1/FIXED2FLOAT(scale);
+		const double cosine = FIXED2FLOAT(amcos), sine = FIXED2FLOAT(amsin);
+		const double halfx = amsizex/2.0, halfy = amsizey/2.0;
+		const double extentx = (fabs(halfx*cosine) + fabs(halfy*sine))*invscale;
+		const double extenty = (fabs(halfx*sine) + fabs(halfy*cosine))*invscale;
+		const double centerx = FIXED2FLOAT(ofsx), centery = FIXED2FLOAT(ofsy);
+		const int minx = MAX(0, static_cast<int>(floor(centerx - extentx)) - 1);
+		const int miny = MAX(0, static_cast<int>(floor(centery - extenty)) - 1);
+		const int maxx = MIN<int>(mapwidth, static_cast<int>(ceil(centerx + extentx)) + 2);
+		const int maxy = MIN<int>(mapheight, static_cast<int>(ceil(centery + extenty)) + 2);
+
+		TileState state;
+		for(int my = miny;my < maxy;++my)
 		{
-			if(!((spot->amFlags & AM_Visible) || am_cheat || gamestate.fullmap) ||
-				((amFlags & AMF_Overlay) && (spot->amFlags & AM_DontOverlay)))
-				continue;
-
-			if(TransformTile(spot, FixedMul((mx<<FRACBITS)-ofsx, scale), FixedMul((my<<FRACBITS)-ofsy, scale), points))
+			MapSpot spot = map->GetSpot(minx, my, 0);
+			for(int mx = minx;mx < maxx;++mx, ++spot)
 			{
-				double texScale = origTexScale;
+				if(!GetTileState(spot, state))
+					continue;
 
-				FTexture *tex;
-				Color *color = NULL;
-				int brightness;
-				if(spot->tile && !spot->pushAmount && !spot->pushReceptor)
+				if(state.kind != TileState::Empty &&
+					TransformTile(spot, FixedMul((mx<<FRACBITS)-ofsx, scale), FixedMul((my<<FRACBITS)-ofsy, scale), points))
 				{
-					brightness = 256;
-					if((amFlags & AMF_DrawTexturedWalls))
+					double texScale = origTexScale;
+					if(state.kind == TileState::Textured)
 					{
-						if(spot->tile->overhead.isValid())
-							tex = TexMan(spot->tile->overhead);
-						else if(spot->tile->offsetHorizontal)
-							tex = TexMan(spot->texture[MapTile::North]);
-						else
-							tex = TexMan(spot->texture[MapTile::East]);
+						// As a special case, since Noah's Ark stores the Automap
+						// graphics in the TILE8, we need to override the scaling.
+						if(state.tex->UseType == FTexture::TEX_FontChar)
+							texScale *= 8;
+						screen->FillSimplePoly(state.tex, &points[0], points.Size(), originx, originy, texScale, texScale, ~amangle, &NormalLight, state.brightness);
 					}
 					else
-					{
-						tex = NULL;
-						if(spot->tile->offsetHorizontal || spot->tile->offsetVertical)
-							color = &DoorColor;
-						else
-							color = &WallColor;
-					}
-				}
-				else if(spot->sector && !(amFlags & AMF_Overlay))
-				{
-					if(amFlags & AMF_DrawFloor)
-					{
-						brightness = 128;
-						tex = TexMan(spot->sector->texture[MapSector::Floor]);
-					}
-					else
-					{
-						brightness = 256;
-						tex = NULL;
-						if(FloorColor.color != BackgroundColor.color)
-							color = &FloorColor;
-					}
-				}
-				else
-				{
-					tex = NULL;
+						screen->FillSimplePoly(NULL, &points[0], points.Size(), originx, originy, texScale, texScale, ~amangle, &NormalLight, state.brightness, state.color->palcolor, state.color->color);
 				}
 
-				if(tex)
-				{
-					// As a special case, since Noah's Ark stores the Automap
-					// graphics in the TILE8, we need to override the scaling.
-					if(tex->UseType == FTexture::TEX_FontChar)
-						texScale *= 8;
-					screen->FillSimplePoly(tex, &points[0], points.Size(), originx, originy, texScale, texScale, ~amangle, &NormalLight, brightness);
-				}
-				else if(color)
-					screen->FillSimplePoly(NULL, &points[0], points.Size(), originx, originy, texScale, texScale, ~amangle, &NormalLight, brightness, color->palcolor, color->color);
-			}
-
-			// We need to check this even if the origin tile isn't visible since
-			// the destination spot may be!
-			if(spot->pushAmount)
-			{
-				fixed tx = (mx<<FRACBITS), ty = my<<FRACBITS;
-				switch(spot->pushDirection)
-				{
-					default:
-					case MapTile::East:
-						tx += (spot->pushAmount<<10);
-						break;
-					case MapTile::West:
-						tx -= (spot->pushAmount<<10);
-						break;
-					case MapTile::South:
-						ty += (spot->pushAmount<<10);
-						break;
-					case MapTile::North:
-						ty -= (spot->pushAmount<<10);
-						break;
-				}
-				if(TransformTile(spot, FixedMul(tx-ofsx, scale), FixedMul(ty-ofsy, scale), points))
-				{
-					AMPWall pwall;
-					pwall.points = points;
-					pwall.texid = spot->tile->overhead.isValid() ? spot->tile->overhead : spot->texture[0];
-					pwall.shiftx = (float)(FIXED2FLOAT(FixedMul(FixedMul(scale, tx&0xFFFF), amcos) - FixedMul(FixedMul(scale, ty&0xFFFF), amsin)));
-					pwall.shifty = (float)(FIXED2FLOAT(FixedMul(FixedMul(scale, tx&0xFFFF), amsin) + FixedMul(FixedMul(scale, ty&0xFFFF), amcos)));
-					pwalls.Push(pwall);
-				}
+				// We need to check this even if the origin tile isn't visible since
+				// the destination spot may be!
+				if(spot->pushAmount)
+					AddPushwall(spot, mx, my, ofsx, ofsy, pwalls);
 			}
 		}
 	}
@@ -624,6 +620,46 @@ void AutoMap::DrawClippedLine(int x0, int y0, int x1, int y1, int palcolor, uint
 	screen->DrawLine(x0, y0+1, x1, y1+1, palcolor, realcolor);
 }
 
+// Resamples the pre-rendered layer onto the automap area. Each screen pixel
+// is transformed back into map space, which is linear along a row.
+void AutoMap::DrawLayer(unsigned int mapwidth, unsigned int mapheight, fixed ofsx, fixed ofsy) const
+{
+	const int x1 = MAX(amx, 0);
+	const int x2 = MIN(amx+amsizex, screen->GetWidth());
+	const int y1 = MAX(amy+1, 0);
+	const int y2 = MIN(amy+amsizey+1, screen->GetHeight());
+	if(x1 >= x2 || y1 >= y2)
+		return;
+
+	const double invscale = 1/FIXED2FLOAT(scale);
+	const double cosine = FIXED2FLOAT(amcos)*invscale;
+	const double sine = FIXED2FLOAT(amsin)*invscale;
+	const fixed stepx = static_cast<fixed>(cosine*FRACUNIT);
+	const fixed stepy = static_cast<fixed>(-sine*FRACUNIT);
+	const int layerBits = FRACBITS - layerShift;
+	const TileState *states = &tileStates[0];
+	const BYTE *src = &layer[0];
+
+	const int pitch = screen->GetPitch();
+	BYTE *dest = screen->GetBuffer() + y1*pitch;
+	const double u = x1 + 0.5 - amx - amsizex/2.0;
+	for(int y = y1;y < y2;++y, dest += pitch)
+	{
+		const double v = y - amy - amsizey/2.0;
+		fixed wx = ofsx + static_cast<fixed>((u*cosine + v*sine)*FRACUNIT);
+		fixed wy = ofsy + static_cast<fixed>((v*cosine - u*sine)*FRACUNIT);
+		for(int x = x1;x < x2;++x, wx += stepx, wy += stepy)
+		{
+			const unsigned int mx = wx>>FRACBITS;
+			const unsigned int my = wy>>FRACBITS;
+			if(mx >= mapwidth || my >= mapheight || states[my*mapwidth+mx].kind == TileState::Empty)
+				continue;
+
+			dest[x] = src[(wy>>layerBits)*layerWidth + (wx>>layerBits)];
+		}
+	}
+}
+
 void AutoMap::DrawStats() const
 {
 	if(!(amFlags & (AMF_DispInfo|AMF_DispRatios)))
@@ -740,6 +776,109 @@ FVector2 AutoMap::GetClipIntersection(const FVector2 &p1, const FVector2 &p2, un
 	}
 }
 
+// Picks the number of layer pixels per tile, as a power of two no smaller
+// than a tile on screen. Returns -1 if the layer would be too large.
+int AutoMap::GetLayerShift(unsigned int mapwidth, unsigned int mapheight) const
+{
+	const fixed tileSize = scale;
+	int shift = 0;
+	while((FRACUNIT<<shift) < tileSize)
+		++shift;
+
+	if(shift > 6 || (MAX(mapwidth, mapheight)<<shift) > AM_MAXLAYERSIZE)
+		return -1;
+	return shift;
+}
+
+// Determines how a spot should be drawn. Returns false if the spot isn't
+// shown at all, in which case any pushwall in it should be hidden as well.
+bool AutoMap::GetTileState(MapSpot spot, TileState &state) const
+{
+	state.kind = TileState::Empty;
+	state.tex = NULL;
+	state.color = NULL;
+	state.brightness = 256;
+
+	if(!((spot->amFlags & AM_Visible) || am_cheat || gamestate.fullmap) ||
+		((amFlags & AMF_Overlay) && (spot->amFlags & AM_DontOverlay)))
+		return false;
+
+	if(spot->tile && !spot->pushAmount && !spot->pushReceptor)
+	{
+		if((amFlags & AMF_DrawTexturedWalls))
+		{
+			if(spot->tile->overhead.isValid())
+				state.tex = TexMan(spot->tile->overhead);
+			else if(spot->tile->offsetHorizontal)
+				state.tex = TexMan(spot->texture[MapTile::North]);
+			else
+				state.tex = TexMan(spot->texture[MapTile::East]);
+		}
+		else
+		{
+			if(spot->tile->offsetHorizontal || spot->tile->offsetVertical)
+				state.color = &DoorColor;
+			else
+				state.color = &WallColor;
+		}
+	}
+	else if(spot->sector && !(amFlags & AMF_Overlay))
+	{
+		if(amFlags & AMF_DrawFloor)
+		{
+			state.brightness = 128;
+			state.tex = TexMan(spot->sector->texture[MapSector::Floor]);
+		}
+		else if(FloorColor.color != BackgroundColor.color)
+			state.color = &FloorColor;
+	}
+
+	if(state.tex)
+		state.kind = TileState::Textured;
+	else if(state.color)
+		state.kind = TileState::Solid;
+	return true;
+}
+
+// Draws one tile into the layer, anchoring textures to the map origin the
+// same way FillSimplePoly would.
+void AutoMap::RenderLayerTile(unsigned int mx, unsigned int my, const TileState &state)
+{
+	const unsigned int size = 1<<layerShift;
+	BYTE *dest = &layer[(my<<layerShift)*layerWidth + (mx<<layerShift)];
+
+	if(state.kind == TileState::Solid)
+	{
+		for(unsigned int y = 0;y < size;++y, dest += layerWidth)
+			memset(dest, state.color->palcolor, size);
+	}
+	else if(state.kind == TileState::Textured)
+	{
+		FTexture *tex = state.tex;
+		const BYTE *pixels = tex->GetPixels();
+		const int shade = LIGHT2SHADE(state.brightness) - 12*FRACUNIT;
+		const BYTE *colormap = &NormalLight.Maps[clamp(shade>>FRACBITS, 0, NUMCOLORMAPS-1)*256];
+		const unsigned int texWidth = tex->GetWidth();
+		const unsigned int texHeight = tex->GetHeight();
+
+		// Texels covered by a single tile.
+		const double tileTexels = tex->UseType == FTexture::TEX_FontChar ? 8 : 64;
+		const double texelsx = tileTexels*FIXED2FLOAT(tex->xScale);
+		const double texelsy = tileTexels*FIXED2FLOAT(tex->yScale);
+
+		unsigned int columns[64];
+		for(unsigned int x = 0;x < size;++x)
+			columns[x] = (static_cast<unsigned int>((mx + (x + 0.5)/size)*texelsx) % texWidth)*texHeight;
+
+		for(unsigned int y = 0;y < size;++y, dest += layerWidth)
+		{
+			const unsigned int row = static_cast<unsigned int>((my + (y + 0.5)/size)*texelsy) % texHeight;
+			for(unsigned int x = 0;x < size;++x)
+				dest[x] = colormap[pixels[columns[x] + row]];
+		}
+	}
+}
+
 void AutoMap::SetFlags(unsigned int flags, bool set)
 {
 	if(set)
@@ -822,6 +961,47 @@ bool AutoMap::TransformTile(MapSpot spot, fixed x, fixed y, TArray<FVector2> &po
 	return true;
 }
 
+// Brings the layer up to date, redrawing only the tiles whose appearance
+// changed since the last frame. Also collects the visible pushwalls which
+// are drawn separately since they move.
+void AutoMap::UpdateLayer(unsigned int mapwidth, unsigned int mapheight, int shift, TArray<MapSpot> &pushwalls)
+{
+	const unsigned int numTiles = mapwidth*mapheight;
+	if(shift != layerShift || tileStates.Size() != numTiles || layerWidth != (mapwidth<<shift))
+	{
+		layerShift = shift;
+		layerWidth = mapwidth<<shift;
+		layer.Resize(layerWidth*(mapheight<<shift));
+
+		TileState invalid;
+		invalid.kind = TileState::Invalid;
+		invalid.tex = NULL;
+		invalid.color = NULL;
+		invalid.brightness = 0;
+		tileStates.Resize(numTiles);
+		for(unsigned int i = 0;i < numTiles;++i)
+			tileStates[i] = invalid;
+	}
+
+	TileState state;
+	TileState *cached = &tileStates[0];
+	for(unsigned int my = 0;my < mapheight;++my)
+	{
+		MapSpot spot = map->GetSpot(0, my, 0);
+		for(unsigned int mx = 0;mx < mapwidth;++mx, ++spot, ++cached)
+		{
+			if(GetTileState(spot, state) && spot->pushAmount)
+				pushwalls.Push(spot);
+
+			if(state != *cached)
+			{
+				*cached = state;
+				RenderLayerTile(mx, my, state);
+			}
+		}
+	}
+}
+
 void BasicOverhead()
 {
 	if(am_needsrecalc)
@@ -63,6 +63,7 @@ void AM_Toggle();
 
 void BasicOverhead();
 
+struct AMPWall;
 struct AMVectorPoint;
 
 class AutoMap
@@ -97,13 +98,37 @@ public:
 	void SetScale(fixed scale, bool relative);
 
 protected:
+	// What a map cell looks like on the automap. The layer is only redrawn
+	// for cells where this changes.
+	struct TileState
+	{
+		enum { Empty, Solid, Textured, Invalid };
+
+		FTexture *tex;
+		const Color *color;
+		int brightness;
+		BYTE kind;
+
+		bool operator!=(const TileState &other) const
+		{
+			return kind != other.kind || tex != other.tex ||
+				color != other.color || brightness != other.brightness;
+		}
+	};
+
+	void AddPushwall(MapSpot spot, unsigned int mx, unsigned int my, fixed ofsx, fixed ofsy, TArray<AMPWall> &pwalls) const;
 	void ClipTile(TArray<FVector2> &points) const;
 	void DrawActor(class AActor *actor, fixed x, fixed y);
 	void DrawClippedLine(int x0, int y0, int x1, int y1, int palcolor, uint32 realcolor) const;
+	void DrawLayer(unsigned int mapwidth, unsigned int mapheight, fixed ofsx, fixed ofsy) const;
 	void DrawStats() const;
 	void DrawVector(const AMVectorPoint *points, unsigned int numPoints, fixed x, fixed y, angle_t angle, const Color &c) const;
 	FVector2 GetClipIntersection(const FVector2 &p1, const FVector2 &p2, unsigned edge) const;
+	int GetLayerShift(unsigned int mapwidth, unsigned int mapheight) const;
+	bool GetTileState(MapSpot spot, TileState &state) const;
+	void RenderLayerTile(unsigned int mx, unsigned int my, const TileState &state);
 	bool TransformTile(MapSpot spot, fixed x, fixed y, TArray<FVector2> &points) const;
+	void UpdateLayer(unsigned int mapwidth, unsigned int mapheight, int shift, TArray<MapSpot> &pushwalls);
 
 private:
 	double rottable[2][2];
@@ -117,6 +142,12 @@ private:
 	angle_t amangle;
 	unsigned short minmaxSel;
 
+	// Pre-rendered copy of the map with (1<<layerShift) pixels per tile.
+	TArray<TileState> tileStates;
+	TArray<BYTE> layer;
+	int layerShift;
+	unsigned int layerWidth;
+
 	Color ArrowColor;
 	Color BackgroundColor;
 	Color FloorColor;
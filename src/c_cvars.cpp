@@ -50,6 +50,9 @@ Aspect r_ratio = ASPECT_4_3, vid_aspect = ASPECT_NONE;
 bool forcegrabmouse = false;
 bool vid_fullscreen = false;
 bool vid_vsync = false;
+bool vid_asyncpresent = false;
+bool vid_interpolate = true;
+bool vid_framecoherence = false;
 bool quitonescape = false;
 fixed movebob = FRACUNIT;
 
@@ -189,6 +192,9 @@ void ReadConfig(void)
 	config.CreateSetting("Vid_FullScreen", false);
 	config.CreateSetting("Vid_Aspect", ASPECT_NONE);
 	config.CreateSetting("Vid_Vsync", false);
+	config.CreateSetting("Vid_AsyncPresent", false);
+	config.CreateSetting("Vid_Interpolate", true);
+	config.CreateSetting("Vid_FrameCoherence", false);
 	config.CreateSetting("FullScreenWidth", fullScreenWidth);
 	config.CreateSetting("FullScreenHeight", fullScreenHeight);
 	config.CreateSetting("WindowedScreenWidth", windowedScreenWidth);
@@ -246,6 +252,9 @@ void ReadConfig(void)
 	vid_fullscreen = config.GetSetting("Vid_FullScreen")->GetInteger() != 0;
 	vid_aspect = static_cast<Aspect>(config.GetSetting("Vid_Aspect")->GetInteger());
 	vid_vsync = config.GetSetting("Vid_Vsync")->GetInteger() != 0;
+	vid_asyncpresent = config.GetSetting("Vid_AsyncPresent")->GetInteger() != 0;
+	vid_interpolate = config.GetSetting("Vid_Interpolate")->GetInteger() != 0;
+	vid_framecoherence = config.GetSetting("Vid_FrameCoherence")->GetInteger() != 0;
 	fullScreenWidth = config.GetSetting("FullScreenWidth")->GetInteger();
 	fullScreenHeight = config.GetSetting("FullScreenHeight")->GetInteger();
 	windowedScreenWidth = config.GetSetting("WindowedScreenWidth")->GetInteger();
@@ -398,6 +407,9 @@ void WriteConfig(void)
 	config.GetSetting("Vid_FullScreen")->SetValue(vid_fullscreen);
 	config.GetSetting("Vid_Aspect")->SetValue(vid_aspect);
 	config.GetSetting("Vid_Vsync")->SetValue(vid_vsync);
+	config.GetSetting("Vid_AsyncPresent")->SetValue(vid_asyncpresent);
+	config.GetSetting("Vid_Interpolate")->SetValue(vid_interpolate);
+	config.GetSetting("Vid_FrameCoherence")->SetValue(vid_framecoherence);
 	config.GetSetting("FullScreenWidth")->SetValue(fullScreenWidth);
 	config.GetSetting("FullScreenHeight")->SetValue(fullScreenHeight);
 	config.GetSetting("WindowedScreenWidth")->SetValue(windowedScreenWidth);
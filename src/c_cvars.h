@@ -59,6 +59,9 @@ extern bool		r_depthfog;
 extern bool		vid_fullscreen;
 extern Aspect	vid_aspect;
 extern bool		vid_vsync;
+extern bool		vid_asyncpresent;
+extern bool		vid_interpolate;
+extern bool		vid_framecoherence;
 extern bool		quitonescape;
 extern fixed	movebob;
 
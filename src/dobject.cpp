@@ -37,6 +37,7 @@
 
 //#include "cmdlib.h"
 #include "dobject.h"
+#include "dobjpool.h"
 #include "actordef.h"
 //#include "doomstat.h"		// Ideally, DObjects can be used independant of Doom.
 //#include "d_player.h"		// See p_user.cpp to find out why this doesn't work.
@@ -237,6 +238,25 @@ DObject *DObject::__InPlaceConstructor(const ClassDef *classDef, void *mem)
 	return new ((EInPlace *)mem) DObject(classDef);
 }
 
+void *DObject::operator new(size_t len)
+{
+	FObjectHeader *header = (FObjectHeader *)M_Malloc(sizeof(FObjectHeader) + len);
+	header->Pool = NULL;
+	return header + 1;
+}
+
+void DObject::operator delete (void *mem)
+{
+	if (mem == NULL)
+		return;
+
+	FObjectHeader *header = (FObjectHeader *)mem - 1;
+	if (header->Pool != NULL)
+		header->Pool->Free(header);
+	else
+		M_Free(header);
+}
+
 DObject::DObject ()
 : Class(0), ObjectFlags(0)
 {
@@ -46,6 +46,16 @@ class AActor;
 
 enum EInPlace { EC_InPlace };
 
+class FObjectPool;
+
+// Every DObject is preceded by this header, which records the pool the
+// memory came from or NULL if it was allocated from the heap.
+union FObjectHeader
+{
+	FObjectPool *Pool;
+	double Align;
+};
+
 
 enum EObjectFlags
 {
@@ -107,6 +117,19 @@ namespace GC
 	// Size of GC steps.
 	extern int StepMul;
 
+	// Time in microseconds FrameStep may spend collecting. When non-zero,
+	// CheckGC leaves the work for FrameStep unless the debt exceeds
+	// MaxDeferred.
+	extern int PauseTarget;
+	extern size_t MaxDeferred;
+
+	// True while the running loop calls FrameStep every frame. Only then
+	// does CheckGC defer to it.
+	extern bool Slicing;
+
+	// Number of steps CheckGC had to force while collection was deferred.
+	extern int ForcedSteps;
+
 	// Current white value for known-dead objects.
 	static inline uint32 OtherWhite()
 	{
@@ -119,6 +142,13 @@ namespace GC
 	// Does one collection step.
 	void Step();
 
+	// Does collection steps for up to PauseTarget microseconds.
+	void FrameStep();
+
+	// Called for every frame shown. Loops which don't call FrameStep get a
+	// step here whenever one is due.
+	void EndFrame();
+
 	// Does a complete collection.
 	void FullGC();
 
@@ -145,7 +175,15 @@ namespace GC
 	static inline void CheckGC()
 	{
 		if (AllocBytes >= Threshold)
-			Step();
+		{
+			if (PauseTarget == 0 || !Slicing)
+				Step();
+			else if (AllocBytes - Threshold >= MaxDeferred)
+			{
+				++ForcedSteps;
+				Step();
+			}
+		}
 	}
 
 	// Forces a collection to start now.
@@ -339,15 +377,8 @@ public:
 		Class = inClass;
 	}
 
-	void *operator new(size_t len)
-	{
-		return M_Malloc(len);
-	}
-
-	void operator delete (void *mem)
-	{
-		M_Free(mem);
-	}
+	void *operator new(size_t len);
+	void operator delete (void *mem);
 
 	// GC fiddling
 
@@ -413,7 +444,7 @@ protected:
 
 	void operator delete (void *mem, EInPlace *)
 	{
-		M_Free (mem);
+		operator delete (mem);
 	}
 
 	virtual void	Init() {}
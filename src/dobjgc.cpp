@@ -66,7 +66,7 @@
 //#include "g_game.h"
 //#include "a_sharedglobal.h"
 //#include "sbar.h"
-//#include "stats.h"
+#include "stats.h"
 //#include "c_dispatch.h"
 //#include "p_acs.h"
 //#include "s_sndseq.h"
@@ -81,6 +81,7 @@
 #include "wl_net.h"
 #include "thingdef/thingdef.h"
 #include "id_ca.h"
+#include "dobjpool.h"
 
 // MACROS ------------------------------------------------------------------
 
@@ -103,6 +104,16 @@
 */
 #define DEFAULT_GCMUL		400 // GC runs 'quadruple the speed' of memory allocation
 
+/*
+@@ DEFAULT_GCPAUSETARGET is the time in microseconds that FrameStep may
+@* spend collecting each frame. 0 runs steps as soon as they are due.
+*/
+#define DEFAULT_GCPAUSETARGET	1000
+
+// Amount of debt allowed to build up while waiting for the frame slice
+// before a step is forced anyway.
+#define DEFAULT_GCMAXDEFERRED	(1024*1024)
+
 // Number of sectors to mark for each step.
 #define SECTORSTEPSIZE	32
 #define POLYSTEPSIZE 120
@@ -157,6 +168,22 @@ int Pause = DEFAULT_GCPAUSE;
 int StepMul = DEFAULT_GCMUL;
 int StepCount;
 size_t Dept;
+int PauseTarget = DEFAULT_GCPAUSETARGET;
+size_t MaxDeferred = DEFAULT_GCMAXDEFERRED;
+int ForcedSteps;
+bool Slicing;
+
+// Telemetry for the most recent frame slice.
+static cycle_t FrameTime;
+static int FrameSteps;
+static bool SliceTaken;
+static unsigned int FrameFreed;
+static unsigned int TotalFreed, LastTotalFreed;
+static double WindowPeak, LastPeak;
+static unsigned int WindowFrames;
+
+// Work limit for each step in the frame slice, adjusted to the target.
+static size_t SliceLimit;
 
 // PRIVATE DATA DEFINITIONS ------------------------------------------------
 
@@ -258,6 +285,7 @@ static DObject **SweepList(DObject **p, size_t count, size_t *finalize_count)
 			curr->ObjectFlags |= OF_Cleanup;
 			delete curr;
 			finalized++;
+			TotalFreed++;
 		}
 	}
 	if (finalize_count != NULL)
@@ -444,21 +472,16 @@ static size_t SingleStep()
 
 //==========================================================================
 //
-// Step
+// LimitedStep
 //
-// Performs enough single steps to cover GCSTEPSIZE * StepMul% bytes of
-// memory.
+// Performs single steps until lim units of work have been done and pays
+// off one step's worth of debt.
 //
 //==========================================================================
 
-void Step()
+static void LimitedStep(size_t lim)
 {
-	size_t lim = (GCSTEPSIZE/100) * StepMul;
 	size_t olim;
-	if (lim == 0)
-	{
-		lim = (~(size_t)0) / 2;		// no limit
-	}
 	Dept += AllocBytes - Threshold;
 	do
 	{
@@ -485,6 +508,111 @@ void Step()
 	StepCount++;
 }
 
+//==========================================================================
+//
+// Step
+//
+// Performs enough single steps to cover GCSTEPSIZE * StepMul% bytes of
+// memory.
+//
+//==========================================================================
+
+void Step()
+{
+	// Steps forced from CheckGC happen while thinkers are ticking
+	FProfileScope profile(PROF_GC);
+
+	size_t lim = (GCSTEPSIZE/100) * StepMul;
+	if (lim == 0)
+	{
+		lim = (~(size_t)0) / 2;		// no limit
+	}
+	LimitedStep(lim);
+}
+
+//==========================================================================
+//
+// FrameStep
+//
+// Pays off the debt accumulated since the last frame within a slice of
+// PauseTarget microseconds. The size of each step is adjusted so that a
+// slice takes several steps, which keeps the overshoot small without
+// reading the clock after every bit of work.
+//
+//==========================================================================
+
+void FrameStep()
+{
+	FrameTime.Reset();
+	FrameSteps = 0;
+	SliceTaken = true;
+
+	if (PauseTarget == 0)
+	{
+		FrameTime.Clock();
+		CheckGC();
+		FrameTime.Unclock();
+	}
+	else if (AllocBytes >= Threshold)
+	{
+		const size_t minLimit = MAX<size_t>((GCSTEPSIZE/100) * StepMul, GCSTEPSIZE);
+		const size_t maxLimit = minLimit * 64;
+		const double target = PauseTarget / 1000.;
+		double spent = 0;
+
+		if (SliceLimit < minLimit)
+			SliceLimit = minLimit;
+
+		FrameTime.Clock();
+		do
+		{
+			const QWORD start = I_ClockNow();
+			LimitedStep(SliceLimit);
+			const double elapsed = (I_ClockNow() - start) * PerfToMillisec;
+			spent += elapsed;
+			++FrameSteps;
+
+			if (elapsed > target/4 && SliceLimit > minLimit)
+				SliceLimit /= 2;
+			else if (elapsed < target/16 && SliceLimit < maxLimit)
+				SliceLimit *= 2;
+		}
+		while (AllocBytes >= Threshold && spent < target);
+		FrameTime.Unclock();
+	}
+
+	FrameFreed = TotalFreed - LastTotalFreed;
+	LastTotalFreed = TotalFreed;
+
+	const double ms = FrameTime.TimeMS();
+	if (ms > WindowPeak)
+		WindowPeak = ms;
+	if (++WindowFrames >= TICRATE)
+	{
+		LastPeak = WindowPeak;
+		WindowPeak = 0;
+		WindowFrames = 0;
+	}
+}
+
+//==========================================================================
+//
+// EndFrame
+//
+// Menus, intermissions and the like don't call FrameStep, so while they
+// are running keep collecting as allocations are made instead of letting
+// the debt build up until a step is forced.
+//
+//==========================================================================
+
+void EndFrame()
+{
+	Slicing = SliceTaken;
+	SliceTaken = false;
+	if (!Slicing)
+		CheckGC();
+}
+
 //==========================================================================
 //
 // FullGC
@@ -716,7 +844,6 @@ size_t DSectorMarker::PropagateMark()
 //
 //==========================================================================
 
-#if 0
 ADD_STAT(gc)
 {
 	static const char *StateStrings[] = {
@@ -735,9 +862,25 @@ ADD_STAT(gc)
 	{
 		out.AppendFormat("  %zuK", (GC::Dept + 1023) >> 10);
 	}
+
+	unsigned int used, capacity;
+	size_t slabBytes;
+	FObjectPool::StaticGetOccupancy(used, capacity, slabBytes);
+	out.AppendFormat("\nPools: %u/%u slots  Slabs:%6zuK", used, capacity, (slabBytes + 1023) >> 10);
+
+	unsigned int objects = 0;
+	for (DObject *obj = GC::Root; obj != NULL; obj = obj->ObjNext)
+	{
+		objects++;
+	}
+	out.AppendFormat("\nObjects: %u  Freed: %u  Slice: %.2fms/%d steps  Peak: %.2fms  Forced: %d",
+		objects, GC::FrameFreed, GC::FrameTime.TimeMS(), GC::FrameSteps,
+		MAX(GC::WindowPeak, GC::LastPeak), GC::ForcedSteps);
 	return out;
 }
 
+#if 0
+
 //==========================================================================
 //
 // CCMD gc
@@ -0,0 +1,137 @@
+/*
+** dobjpool.cpp
+** Slab allocator for DObjects created through ClassDef::CreateInstance
+**
+**---------------------------------------------------------------------------
+** Copyright 2026
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+*/
+
+#include <stdlib.h>
+
+#include "dobjpool.h"
+#include "templates.h"
+#include "zdoomsupport.h"
+
+// Free slots are chained together through the first bytes of the object.
+#define NEXTFREE(header) (*(FObjectHeader **)((header)+1))
+
+// Aim for slabs of around this size, but always fit a few objects.
+enum { SLAB_SIZE = 16*1024, MIN_SLAB_SLOTS = 8 };
+
+FObjectPool *FObjectPool::FirstPool = NULL;
+
+FObjectPool::FObjectPool (size_t objectSize)
+: Slabs(NULL), FreeList(NULL), Used(0), Capacity(0), PrevPool(NULL), NextPool(FirstPool)
+{
+	// Keep every slot aligned the same way as the header.
+	const size_t align = sizeof(FObjectHeader);
+	SlotSize = (sizeof(FObjectHeader) + objectSize + align - 1) & ~(align - 1);
+	SlotsPerSlab = MAX<unsigned int>(MIN_SLAB_SLOTS, SLAB_SIZE / SlotSize);
+
+	if (FirstPool)
+		FirstPool->PrevPool = this;
+	FirstPool = this;
+}
+
+FObjectPool::~FObjectPool ()
+{
+	assert(Used == 0);
+
+	while (Slabs)
+	{
+		Slab *next = Slabs->Next;
+		free (Slabs);
+		Slabs = next;
+	}
+
+	if (PrevPool)
+		PrevPool->NextPool = NextPool;
+	else
+		FirstPool = NextPool;
+	if (NextPool)
+		NextPool->PrevPool = PrevPool;
+}
+
+void *FObjectPool::Alloc ()
+{
+	if (FreeList == NULL)
+		NewSlab ();
+
+	FObjectHeader *header = FreeList;
+	FreeList = NEXTFREE(header);
+	++Used;
+
+	// Account for the slot as if it were allocated with M_Malloc so the
+	// collector is paced the same way regardless of where memory comes from.
+	GC::AllocBytes += SlotSize;
+	return header + 1;
+}
+
+void FObjectPool::Free (FObjectHeader *header)
+{
+	assert(header->Pool == this);
+
+	NEXTFREE(header) = FreeList;
+	FreeList = header;
+	--Used;
+	GC::AllocBytes -= SlotSize;
+}
+
+void FObjectPool::NewSlab ()
+{
+	Slab *slab = (Slab *)malloc (sizeof(Slab) + SlotsPerSlab * SlotSize);
+	if (slab == NULL)
+		I_FatalError ("Could not allocate object pool slab");
+
+	slab->Next = Slabs;
+	Slabs = slab;
+
+	// Thread the free list front to back so consecutive allocations are
+	// adjacent in memory.
+	BYTE *slots = (BYTE *)(slab + 1);
+	for (unsigned int i = SlotsPerSlab; i-- > 0;)
+	{
+		FObjectHeader *header = (FObjectHeader *)(slots + i * SlotSize);
+		header->Pool = this;
+		NEXTFREE(header) = FreeList;
+		FreeList = header;
+	}
+	Capacity += SlotsPerSlab;
+}
+
+void FObjectPool::StaticGetOccupancy (unsigned int &used, unsigned int &capacity, size_t &slabBytes)
+{
+	used = capacity = 0;
+	slabBytes = 0;
+	for (FObjectPool *pool = FirstPool; pool != NULL; pool = pool->NextPool)
+	{
+		used += pool->Used;
+		capacity += pool->Capacity;
+		slabBytes += (pool->Capacity / pool->SlotsPerSlab) * (sizeof(Slab) + pool->SlotsPerSlab * pool->SlotSize);
+	}
+}
@@ -0,0 +1,81 @@
+/*
+** dobjpool.h
+** Slab allocator for DObjects created through ClassDef::CreateInstance
+**
+**---------------------------------------------------------------------------
+** Copyright 2026
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+*/
+
+#ifndef __DOBJPOOL_H__
+#define __DOBJPOOL_H__
+
+#include "dobject.h"
+
+// Hands out fixed size slots for one class. Slots are carved out of larger
+// slabs so instances of the same class end up next to each other, and freed
+// slots are reused before anything new is allocated. Slabs are kept until
+// the pool is destroyed.
+class FObjectPool
+{
+public:
+	FObjectPool (size_t objectSize);
+	~FObjectPool ();
+
+	void *Alloc ();
+	void Free (FObjectHeader *header);
+
+	unsigned int GetUsed () const { return Used; }
+	unsigned int GetCapacity () const { return Capacity; }
+
+	// Totals across every pool, for the GC stats.
+	static void StaticGetOccupancy (unsigned int &used, unsigned int &capacity, size_t &slabBytes);
+
+private:
+	union Slab
+	{
+		Slab *Next;
+		double Align;
+	};
+
+	void NewSlab ();
+
+	size_t SlotSize;
+	unsigned int SlotsPerSlab;
+	Slab *Slabs;
+	FObjectHeader *FreeList;
+	unsigned int Used;
+	unsigned int Capacity;
+
+	FObjectPool *PrevPool, *NextPool;
+	static FObjectPool *FirstPool;
+
+	FObjectPool (const FObjectPool &) {}
+	FObjectPool &operator= (const FObjectPool &) { return *this; }
+};
+
+#endif
@@ -136,10 +136,6 @@ static inline void SWAP_FLOAT(float &x)
 }
 #endif
 
-// Output buffer size for compression; need some extra space.
-// I assume the description in zlib.h is accurate.
-#define OUT_LEN(a)		((a) + (a) / 1000 + 12)
-
 void FCompressedFile::BeEmpty ()
 {
 	m_Pos = 0;
@@ -367,59 +363,80 @@ FFile &FCompressedFile::Seek (int pos, ESeekPos ofs)
 //CVAR (Bool, nofilecompression, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 static const bool nofilecompression = false;
 
+// The data is deflated a piece at a time into a buffer that starts at a
+// fraction of the input size and grows as needed, rather than reserving
+// the worst case up front and copying the result afterwards. Output is the
+// same as compress() would produce.
 void FCompressedFile::Implode ()
 {
-	uLong outlen;
+	uLong outlen = 0;
 	uLong len = m_BufferSize;
-	Byte *compressed = NULL;
 	BYTE *oldbuf = m_Buffer;
-	int r;
+	BYTE *imploded = NULL;
 
-	if (!nofilecompression && !m_NoCompress)
+	if (!nofilecompression && !m_NoCompress && len > 0)
 	{
-		outlen = OUT_LEN(len);
-		do
+		z_stream stream;
+		memset (&stream, 0, sizeof(stream));
+		if (deflateInit (&stream, Z_DEFAULT_COMPRESSION) == Z_OK)
 		{
-			compressed = new Bytef[outlen];
-			r = compress (compressed, &outlen, m_Buffer, len);
-			if (r == Z_BUF_ERROR)
+			uLong capacity = MIN<uLong> (len, MAX<uLong> (len / 4, 4096));
+			int r;
+
+			imploded = (BYTE *)M_Malloc (capacity + 8);
+			stream.next_in = oldbuf;
+			stream.avail_in = len;
+			do
 			{
-				delete[] compressed;
-				outlen += 1024;
-			}
-		} while (r == Z_BUF_ERROR);
+				if (stream.total_out == capacity)
+				{
+					// Not worth going past the size of the input.
+					if (capacity == len)
+						break;
+					capacity = MIN<uLong> (capacity * 2, len);
+					imploded = (BYTE *)M_Realloc (imploded, capacity + 8);
+				}
+				stream.next_out = imploded + 8 + stream.total_out;
+				stream.avail_out = capacity - stream.total_out;
+				r = deflate (&stream, Z_FINISH);
+			} while (r == Z_OK);
+
+			if (r == Z_STREAM_END && stream.total_out < len)
+				outlen = stream.total_out;
+			deflateEnd (&stream);
+		}
 
 		// If the data could not be compressed, store it as-is.
-		if (r != Z_OK || outlen >= len)
+		if (outlen == 0)
 		{
 			DPrintf ("cfile could not be compressed\n");
-			outlen = 0;
 		}
 		else
 		{
 			DPrintf ("cfile shrank from %lu to %lu bytes\n", len, outlen);
 		}
 	}
+
+	if (outlen == 0)
+	{
+		if (imploded)
+			M_Free (imploded);
+		imploded = (BYTE *)M_Realloc (oldbuf, len + 8);
+		memmove (imploded + 8, imploded, len);
+	}
 	else
 	{
-		outlen = 0;
+		imploded = (BYTE *)M_Realloc (imploded, outlen + 8);
+		M_Free (oldbuf);
 	}
 
+	m_Buffer = imploded;
 	m_MaxBufferSize = m_BufferSize = ((outlen == 0) ? len : outlen);
-	m_Buffer = (BYTE *)M_Malloc (m_BufferSize + 8);
 	m_Pos = 0;
 
 	DWORD *lens = (DWORD *)(m_Buffer);
 	lens[0] = BigLong((unsigned int)outlen);
 	lens[1] = BigLong((unsigned int)len);
-
-	if (outlen == 0)
-		memcpy (m_Buffer + 8, oldbuf, len);
-	else
-		memcpy (m_Buffer + 8, compressed, outlen);
-	if (compressed)
-		delete[] compressed;
-	M_Free (oldbuf);
 }
 
 void FCompressedFile::Explode ()
@@ -605,6 +622,111 @@ void FCompressedMemFile::Serialize (FArchive &arc)
 	}
 }
 
+//==========================================================================
+//
+// FCompressedMemFile :: WritePNGChunk
+//
+// Writes a file which is still open for writing to a PNG chunk in the same
+// form as storing it through an FPNGChunkArchive would, except the data is
+// deflated straight into the file instead of being imploded in memory
+// first. The sizes and CRC are filled in afterwards. Nothing is allocated
+// through M_Malloc, so this may be called from another thread as long as
+// the file isn't touched otherwise in the mean time.
+//
+//==========================================================================
+
+bool FCompressedMemFile::WritePNGChunk (FILE *file, DWORD id)
+{
+	if (m_Mode != EWriting || m_Buffer == NULL)
+	{
+		return false;
+	}
+
+	const long start = ftell (file);
+	DWORD head[2] = { 0, id };
+	DWORD sizes[2] = { 0, BigLong((unsigned int)m_BufferSize) };
+	if (start < 0 ||
+		fwrite (head, 8, 1, file) != 1 ||
+		fwrite (ZSig, 4, 1, file) != 1 ||
+		fwrite (sizes, 8, 1, file) != 1)
+	{
+		return false;
+	}
+
+	DWORD datacrc = 0;
+	uLong outlen = 0;
+	bool ok = true;
+	if (!nofilecompression && !m_NoCompress && m_BufferSize > 0)
+	{
+		z_stream stream;
+		memset (&stream, 0, sizeof(stream));
+		if (deflateInit (&stream, Z_DEFAULT_COMPRESSION) == Z_OK)
+		{
+			Bytef out[16384];
+			int r = Z_OK;
+
+			stream.next_in = m_Buffer;
+			stream.avail_in = m_BufferSize;
+			do
+			{
+				// Never write more than the uncompressed size so that storing
+				// it instead will cover everything written here.
+				stream.next_out = out;
+				stream.avail_out = MIN<uInt> (sizeof(out), m_BufferSize - stream.total_out);
+				if (stream.avail_out == 0)
+					break;
+				r = deflate (&stream, Z_FINISH);
+
+				const unsigned int have = (unsigned int)(stream.next_out - out);
+				if (have > 0)
+				{
+					if (fwrite (out, have, 1, file) != 1)
+					{
+						ok = false;
+						break;
+					}
+					datacrc = AddCRC32 (datacrc, out, have);
+				}
+			} while (r == Z_OK);
+
+			if (ok && r == Z_STREAM_END && stream.total_out < m_BufferSize)
+				outlen = stream.total_out;
+			deflateEnd (&stream);
+		}
+		if (!ok)
+		{
+			return false;
+		}
+	}
+
+	if (outlen == 0)
+	{
+		if (fseek (file, start + 20, SEEK_SET) != 0 ||
+			(m_BufferSize > 0 && fwrite (m_Buffer, m_BufferSize, 1, file) != 1))
+		{
+			return false;
+		}
+		datacrc = CalcCRC32 (m_Buffer, m_BufferSize);
+	}
+
+	const unsigned int chunklen = 12 + (unsigned int)(outlen ? outlen : m_BufferSize);
+	sizes[0] = BigLong((unsigned int)outlen);
+	head[0] = BigLong(chunklen);
+
+	DWORD crc = CalcCRC32 ((BYTE *)&head[1], 4);
+	crc = AddCRC32 (crc, (const BYTE *)ZSig, 4);
+	crc = AddCRC32 (crc, (BYTE *)sizes, 8);
+	crc = crc32_combine (crc, datacrc, chunklen - 12);
+	crc = BigLong((unsigned int)crc);
+
+	return fseek (file, start, SEEK_SET) == 0 &&
+		fwrite (head, 4, 1, file) == 1 &&
+		fseek (file, start + 12, SEEK_SET) == 0 &&
+		fwrite (sizes, 8, 1, file) == 1 &&
+		fseek (file, start + 8 + chunklen, SEEK_SET) == 0 &&
+		fwrite (&crc, 4, 1, file) == 1;
+}
+
 bool FCompressedMemFile::IsOpen () const
 {
 	return !!m_Buffer;
@@ -769,6 +891,15 @@ void FArchive::Close ()
 	}
 }
 
+void FArchive::Detach ()
+{
+	if (m_File)
+	{
+		m_File = NULL;
+		DPrintf ("Processed %u objects\n", m_ObjectCount);
+	}
+}
+
 void FArchive::WriteCount (DWORD count)
 {
 	BYTE out;
@@ -130,6 +130,7 @@ public:
 	void Close ();
 	bool IsOpen () const;
 	void GetSizes(unsigned int &one, unsigned int &two) const;
+	bool WritePNGChunk (FILE *file, DWORD id);	// Stores without imploding in memory
 
 	void Serialize (FArchive &arc);
 
@@ -166,6 +167,7 @@ public:
 		void SetHubTravel () { m_HubTravel = true; }
 
 		void Close ();
+		void Detach ();	// Stops using the file without closing it
 
 virtual	void Write (const void *mem, unsigned int len);
 virtual void Read (void *mem, unsigned int len);
@@ -43,6 +43,14 @@
 #include "templates.h"
 #include "zdoomsupport.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <sys/mman.h>
+#endif
+
 //==========================================================================
 //
 // FileReader
@@ -543,3 +551,72 @@ char *MemoryReader::Gets(char *strbuf, int len)
 {
 	return GetsFromBuffer(bufptr, strbuf, len);
 }
+
+//==========================================================================
+//
+// MappedFileReader
+//
+// The mapping is copy on write so lumps which are fixed up in place don't
+// touch the file, while pages which are only read stay shared with the
+// system's file cache.
+//
+//==========================================================================
+
+MappedFileReader::MappedFileReader ()
+: MemoryReader(NULL, 0), Mapping(NULL)
+#ifdef _WIN32
+, MapHandle(NULL)
+#endif
+{
+}
+
+MappedFileReader::~MappedFileReader ()
+{
+	if (Mapping != NULL)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(Mapping);
+		CloseHandle(MapHandle);
+#else
+		munmap(Mapping, Length);
+#endif
+	}
+}
+
+bool MappedFileReader::Open (const char *filename)
+{
+	FILE *file = ::File(filename).open("rb");
+	if (file == NULL) return false;
+
+	fseek(file, 0, SEEK_END);
+	long length = ftell(file);
+	if (length <= 0)
+	{
+		fclose(file);
+		return false;
+	}
+
+	// The mapping holds its own reference to the file.
+#ifdef _WIN32
+	HANDLE map = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(file)), NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	void *view = map != NULL ? MapViewOfFile(map, FILE_MAP_COPY, 0, 0, 0) : NULL;
+	fclose(file);
+	if (view == NULL)
+	{
+		if (map != NULL)
+			CloseHandle(map);
+		return false;
+	}
+	MapHandle = map;
+#else
+	void *view = mmap(NULL, length, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+	fclose(file);
+	if (view == MAP_FAILED) return false;
+#endif
+
+	Mapping = view;
+	bufptr = (const char *)view;
+	Length = length;
+	FilePos = 0;
+	return true;
+}
@@ -336,6 +336,26 @@ protected:
 	const char * bufptr;
 };
 
+// Maps a whole file into memory so that stored lumps can be used in place
+// rather than copied out of the file.
+class MappedFileReader : public MemoryReader
+{
+public:
+	MappedFileReader ();
+	~MappedFileReader ();
+
+	bool Open (const char *filename);
+
+private:
+	void *Mapping;
+#ifdef _WIN32
+	void *MapHandle;
+#endif
+
+	MappedFileReader (const MappedFileReader &);
+	MappedFileReader &operator= (const MappedFileReader &);
+};
+
 
 
 #endif
@@ -57,7 +57,7 @@ static struct StatusBarConfig_t
 class WolfStatusBar : public DBaseStatusBar
 {
 public:
-	WolfStatusBar() : facecount(0), mac(false)
+	WolfStatusBar() : facecount(0), mac(false), LayoutScreen(NULL), DrawBox(NULL)
 	{
 		if(IWad::CheckGameFilter("Noah"))
 		{
@@ -102,24 +102,74 @@ public:
 	void WeaponGrin();
 
 private:
-	static void LatchNumber (int x, int y, unsigned width, int32_t number, bool zerofill, bool cap=false);
-	static void LatchString (int x, int y, unsigned width, const FString &str);
-	static void StatusDrawFace(FTexture *pic);
-	static void StatusDrawPic(unsigned x, unsigned y, const char* pic);
-
-	void DrawAmmo();
-	void DrawFace();
-	void DrawLevel();
-	void DrawLives();
-	void DrawHealth();
-	void DrawItems();
-	void DrawKeys();
-	void DrawScore();
-	void DrawWeapon();
+	enum
+	{
+		SB_Face,
+		SB_Health,
+		SB_Lives,
+		SB_Level,
+		SB_Ammo,
+		SB_Keys,
+		SB_Weapon,
+		SB_Score,
+		SB_Items,
+
+		NUM_SB_ELEMENTS
+	};
+
+	// What an element shows. Elements are only redrawn when this changes.
+	struct Element
+	{
+		bool shown;
+		FString text;
+		FTexture *pics[2];
+
+		bool operator== (const Element &other) const
+		{
+			return shown == other.shown && pics[0] == other.pics[0] &&
+				pics[1] == other.pics[1] && text.Compare(other.text) == 0;
+		}
+	};
+
+	// Screen area touched when an element was last drawn.
+	struct Box
+	{
+		int x1, y1, x2, y2;
+
+		void Clear() { x1 = y1 = INT_MAX; x2 = y2 = INT_MIN; }
+		bool Intersects(const Box &other) const
+		{
+			return x1 < other.x2 && other.x1 < x2 && y1 < other.y2 && other.y1 < y2;
+		}
+	};
+
+	static FString LatchNumber (unsigned width, int32_t number, bool zerofill, bool cap=false);
+	void LatchString (int x, int y, unsigned width, const FString &str);
+	void StatusDrawPic(unsigned x, unsigned y, FTexture *pic, FRemapTable *remap=NULL);
+
+	void DrawElement(unsigned int element, const Element &state);
+	void GetElement(unsigned int element, Element &state);
+	void RedrawAll(const Element *state);
+	void RestoreBackground(const Box &box);
+	bool UpdateLayout();
 	void SetupStatusbar();
 
 	int facecount;
 	bool mac;
+
+	// The status bar is kept in screen space so that most of the time it
+	// only needs to be copied back. Background is the bare STBAR which is
+	// used to erase elements before they're redrawn.
+	DCanvas *LayoutScreen;
+	int LayoutWidth, LayoutHeight;
+	Box Area;
+	TArray<BYTE> Background, Composite;
+	Element Elements[NUM_SB_ELEMENTS];
+	Box Boxes[NUM_SB_ELEMENTS];
+	Box *DrawBox;
+
+	FTextureID StatusBarPic, DeadFace, MutantFace, KeyPics[7];
+	FFont *HudFont;
 };
 
 DBaseStatusBar *CreateStatusBar_Wolf3D() { return new WolfStatusBar(); }
@@ -132,51 +182,31 @@ DBaseStatusBar *CreateStatusBar_Wolf3D() { return new WolfStatusBar(); }
 ==================
 */
 
-void WolfStatusBar::StatusDrawPic (unsigned x, unsigned y, const char* pic)
+void WolfStatusBar::StatusDrawPic (unsigned x, unsigned y, FTexture *pic, FRemapTable *remap)
 {
-	VWB_DrawGraphic(TexMan(pic), x, 200-(STATUSLINES-y));
-}
-
-void WolfStatusBar::StatusDrawFace(FTexture *pic)
-{
-	VWB_DrawGraphic(pic, StatusBarConfig.Mugshot.X, 200-(STATUSLINES-StatusBarConfig.Mugshot.Y));
-}
-
-
-/*
-==================
-=
-= DrawFace
-=
-==================
-*/
-
-void WolfStatusBar::DrawFace (void)
-{
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Mugshot.Enabled) return;
+	if(!pic)
+		return;
 
-	if(!gamestate.faceframe.isValid())
-	{
-		facecount = 0;
-		UpdateFace();
-	}
+	y = 200-(STATUSLINES-y);
+	VWB_DrawGraphic(pic, x, y, MENU_NONE, remap);
 
-	if (players[ConsolePlayer].health)
-		StatusDrawFace(TexMan(gamestate.faceframe));
-	else
+	if(DrawBox)
 	{
-		// TODO: Make this work based on damage types.
-		// It gets uglier now that we can blame the source of a projectile we
-		// have to check the class that fired it which is just wrong. One of
-		// these days I'll get damage types in!
-		static const ClassDef *schabbs = ClassDef::FindClass("Schabbs");
-		if (players[ConsolePlayer].killerobj && players[ConsolePlayer].killerobj->IsKindOf(schabbs))
-			StatusDrawFace(TexMan("STFMUT0"));
-		else
-			StatusDrawFace(TexMan("STFDEAD0"));
+		double bx = x - pic->GetScaledLeftOffsetDouble();
+		double by = y - pic->GetScaledTopOffsetDouble();
+		double bw = pic->GetScaledWidthDouble();
+		double bh = pic->GetScaledHeightDouble();
+		screen->VirtualToRealCoords(bx, by, bw, bh, 320, 200, true, true);
+
+		// Pad by a pixel in case the scaler rounds differently.
+		DrawBox->x1 = MIN<int>(DrawBox->x1, int(floor(bx))-1);
+		DrawBox->y1 = MIN<int>(DrawBox->y1, int(floor(by))-1);
+		DrawBox->x2 = MAX<int>(DrawBox->x2, int(ceil(bx+bw))+1);
+		DrawBox->y2 = MAX<int>(DrawBox->y2, int(ceil(by+bh))+1);
 	}
 }
 
+
 /*
 ===============
 =
@@ -287,7 +317,7 @@ void WolfStatusBar::UpdateFace (int damage)
 ===============
 */
 
-void WolfStatusBar::LatchNumber (int x, int y, unsigned width, int32_t number, bool zerofill, bool cap)
+FString WolfStatusBar::LatchNumber (unsigned width, int32_t number, bool zerofill, bool cap)
 {
 	FString str;
 	if(zerofill)
@@ -299,224 +329,297 @@ void WolfStatusBar::LatchNumber (int x, int y, unsigned width, int32_t number, b
 		int maxval = width <= 9 ? (int) ceil(pow(10., (int)width))-1 : INT_MAX;
 		str.Format("%d", maxval);
 	}
-
-	LatchString(x, y, width, str);
+	return str;
 }
 
 void WolfStatusBar::LatchString (int x, int y, unsigned width, const FString &str)
 {
-	static FFont *HudFont = NULL;
-	if(!HudFont)
-	{
-		HudFont = V_GetFont("HudFont");
-	}
-
-	y = 200-(STATUSLINES-y);// + HudFont->GetHeight();
-
 	int cwidth;
 	FRemapTable *remap = HudFont->GetColorTranslation(CR_UNTRANSLATED);
 	for(unsigned int i = MAX<int>(0, (int)(str.Len()-width));i < str.Len();++i)
 	{
-		VWB_DrawGraphic(HudFont->GetChar(str[i], &cwidth), x, y, MENU_NONE, remap);
+		StatusDrawPic(x, y, HudFont->GetChar(str[i], &cwidth), remap);
 		x += cwidth;
 	}
 }
 
-
 /*
 ===============
 =
-= DrawHealth
+= GetElement
+=
+= Works out what an element should currently show
 =
 ===============
 */
 
-void WolfStatusBar::DrawHealth (void)
+void WolfStatusBar::GetElement (unsigned int element, Element &state)
 {
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Health.Enabled) return;
-	LatchNumber (StatusBarConfig.Health.X,StatusBarConfig.Health.Y,StatusBarConfig.Health.Digits,players[ConsolePlayer].health,mac,true);
-}
+	player_t &player = players[ConsolePlayer];
 
-//===========================================================================
+	state.shown = false;
+	state.text = "";
+	state.pics[0] = state.pics[1] = NULL;
 
+	switch(element)
+	{
+		case SB_Face:
+			if(!StatusBarConfig.Mugshot.Enabled)
+				return;
 
-/*
-===============
-=
-= DrawLevel
-=
-===============
-*/
+			if(!gamestate.faceframe.isValid())
+			{
+				facecount = 0;
+				UpdateFace();
+			}
 
-void WolfStatusBar::DrawLevel (void)
-{
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Floor.Enabled) return;
-	FString str;
-	str.Format("%*s", StatusBarConfig.Floor.Digits, levelInfo->FloorNumber.GetChars());
-	LatchString (StatusBarConfig.Floor.X,StatusBarConfig.Floor.Y,StatusBarConfig.Floor.Digits,str);
-}
+			if (player.health)
+				state.pics[0] = TexMan(gamestate.faceframe);
+			else
+			{
+				// TODO: Make this work based on damage types.
+				// It gets uglier now that we can blame the source of a projectile we
+				// have to check the class that fired it which is just wrong. One of
+				// these days I'll get damage types in!
+				static const ClassDef *schabbs = ClassDef::FindClass("Schabbs");
+				if (player.killerobj && player.killerobj->IsKindOf(schabbs))
+					state.pics[0] = TexMan(MutantFace);
+				else
+					state.pics[0] = TexMan(DeadFace);
+			}
+			break;
 
-//===========================================================================
+		case SB_Health:
+			if(!StatusBarConfig.Health.Enabled)
+				return;
+			state.text = LatchNumber(StatusBarConfig.Health.Digits, player.health, mac, true);
+			break;
 
+		case SB_Lives:
+			if(!StatusBarConfig.Lives.Enabled || gamestate.difficulty->LivesCount < 0)
+				return;
+			state.text = LatchNumber(StatusBarConfig.Lives.Digits, player.lives, mac);
+			break;
 
-/*
-===============
-=
-= DrawLives
-=
-===============
-*/
+		case SB_Level:
+			if(!StatusBarConfig.Floor.Enabled)
+				return;
+			state.text.Format("%*s", StatusBarConfig.Floor.Digits, levelInfo->FloorNumber.GetChars());
+			break;
 
-void WolfStatusBar::DrawLives (void)
-{
-	if((viewsize == 21 && ingame) || (!StatusBarConfig.Lives.Enabled) || (gamestate.difficulty->LivesCount < 0)) return;
-	LatchNumber (StatusBarConfig.Lives.X,StatusBarConfig.Lives.Y,StatusBarConfig.Lives.Digits,players[ConsolePlayer].lives,mac);
-}
+		case SB_Ammo:
+			if(!StatusBarConfig.Ammo.Enabled ||
+				!player.ReadyWeapon || !player.ReadyWeapon->ammo[AWeapon::PrimaryFire])
+				return;
+			state.text = LatchNumber(StatusBarConfig.Ammo.Digits, player.ReadyWeapon->ammo[AWeapon::PrimaryFire]->amount, mac, true);
+			break;
 
-//===========================================================================
+		case SB_Keys:
+		{
+			if(!StatusBarConfig.Keys.Enabled)
+				return;
+			const bool extendedKeysGraphics = KeyPics[3].isValid();
+			const bool emptyKeysGraphic = KeyPics[0].isValid();
 
+			// Find keys in inventory
+			unsigned int presentKeys = 0;
+			if(player.mo)
+			{
+				for(AInventory *item = player.mo->inventory;item != NULL;item = item->inventory)
+				{
+					if(item->IsKindOf(NATIVE_CLASS(Key)))
+					{
+						unsigned int slot = static_cast<AKey *>(item)->KeyNumber;
+						if(slot <= 4)
+							presentKeys |= 1<<(slot-1);
+						if(presentKeys == 15)
+							break;
+					}
+				}
+			}
 
-/*
-===============
-=
-= DrawItems
-=
-===============
-*/
+			if (extendedKeysGraphics && (presentKeys & (1|4)) == (1|4))
+				state.pics[0] = TexMan(KeyPics[5]);
+			else if(extendedKeysGraphics && (presentKeys & 4))
+				state.pics[0] = TexMan(KeyPics[3]);
+			else if(presentKeys & 1)
+				state.pics[0] = TexMan(KeyPics[1]);
+			else if(emptyKeysGraphic)
+				state.pics[0] = TexMan(KeyPics[0]);
+
+			if (extendedKeysGraphics && (presentKeys & (2|8)) == (2|8))
+				state.pics[1] = TexMan(KeyPics[6]);
+			else if (extendedKeysGraphics && (presentKeys & 8))
+				state.pics[1] = TexMan(KeyPics[4]);
+			else if (presentKeys & 2)
+				state.pics[1] = TexMan(KeyPics[2]);
+			else if (emptyKeysGraphic)
+				state.pics[1] = TexMan(KeyPics[0]);
+			break;
+		}
 
-void WolfStatusBar::DrawItems (void)
-{
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Items.Enabled || players[ConsolePlayer].mo == NULL) return;
+		case SB_Weapon:
+			if(!StatusBarConfig.Weapon.Enabled ||
+				player.ReadyWeapon == NULL ||
+				player.ReadyWeapon->icon.isNull()
+			)
+				return;
+			state.pics[0] = TexMan(player.ReadyWeapon->icon);
+			break;
 
-	AInventory *items = players[ConsolePlayer].mo->FindInventory(ClassDef::FindClass("MacTreasureItem"));
-	unsigned int amount = 0;
-	if(items)
-		amount = items->amount;
+		case SB_Score:
+			if(!StatusBarConfig.Score.Enabled)
+				return;
+			state.text = LatchNumber(StatusBarConfig.Score.Digits, player.score, mac);
+			break;
 
-	LatchNumber (StatusBarConfig.Items.X,StatusBarConfig.Items.Y,StatusBarConfig.Items.Digits,amount,mac);
-}
+		case SB_Items:
+		{
+			if(!StatusBarConfig.Items.Enabled || player.mo == NULL)
+				return;
 
-//===========================================================================
+			AInventory *items = player.mo->FindInventory(ClassDef::FindClass("MacTreasureItem"));
+			unsigned int amount = 0;
+			if(items)
+				amount = items->amount;
+			state.text = LatchNumber(StatusBarConfig.Items.Digits, amount, mac);
+			break;
+		}
+	}
+	state.shown = true;
+}
 
 /*
 ===============
 =
-= DrawScore
+= DrawElement
 =
 ===============
 */
 
-void WolfStatusBar::DrawScore (void)
+void WolfStatusBar::DrawElement (unsigned int element, const Element &state)
 {
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Score.Enabled) return;
-	LatchNumber (StatusBarConfig.Score.X,StatusBarConfig.Score.Y,StatusBarConfig.Score.Digits,players[ConsolePlayer].score,mac);
+	Boxes[element].Clear();
+	if(!state.shown)
+		return;
+
+	DrawBox = &Boxes[element];
+	switch(element)
+	{
+		case SB_Face:
+			StatusDrawPic(StatusBarConfig.Mugshot.X, StatusBarConfig.Mugshot.Y, state.pics[0]);
+			break;
+		case SB_Keys:
+			StatusDrawPic(StatusBarConfig.Keys.X, StatusBarConfig.Keys.Y, state.pics[0]);
+			StatusDrawPic(StatusBarConfig.Keys.X, StatusBarConfig.Keys.Y + (mac ? 20 : 16), state.pics[1]);
+			break;
+		case SB_Weapon:
+			StatusDrawPic(StatusBarConfig.Weapon.X, StatusBarConfig.Weapon.Y, state.pics[0]);
+			break;
+
+		default:
+		{
+			static LatchConfig * const latches[NUM_SB_ELEMENTS] = {
+				NULL, &StatusBarConfig.Health, &StatusBarConfig.Lives,
+				&StatusBarConfig.Floor, &StatusBarConfig.Ammo, NULL,
+				NULL, &StatusBarConfig.Score, &StatusBarConfig.Items
+			};
+			const LatchConfig &latch = *latches[element];
+			LatchString(latch.X, latch.Y, latch.Digits, state.text);
+			break;
+		}
+	}
+	DrawBox = NULL;
 }
 
 //===========================================================================
 
-/*
-==================
-=
-= DrawWeapon
-=
-==================
-*/
-
-void WolfStatusBar::DrawWeapon (void)
+void WolfStatusBar::RefreshBackground(bool noborder)
 {
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Weapon.Enabled ||
-		players[ConsolePlayer].ReadyWeapon == NULL ||
-		players[ConsolePlayer].ReadyWeapon->icon.isNull()
-	)
+	DBaseStatusBar::RefreshBackground(noborder);
+
+	if(viewsize == 21 && ingame)
 		return;
 
-	VWB_DrawGraphic(TexMan(players[ConsolePlayer].ReadyWeapon->icon), StatusBarConfig.Weapon.X, 200-(STATUSLINES-StatusBarConfig.Weapon.Y));
+	VWB_DrawGraphic(TexMan("STBACK"), 0, 160);
 }
 
+// Resolves the graphics and works out where the status bar lands on screen.
+// If anything changed the background is recaptured and true is returned.
+bool WolfStatusBar::UpdateLayout()
+{
+	if(LayoutScreen == screen && LayoutWidth == screen->GetWidth() && LayoutHeight == screen->GetHeight())
+		return false;
 
-/*
-==================
-=
-= DrawKeys
-=
-==================
-*/
+	LayoutScreen = screen;
+	LayoutWidth = screen->GetWidth();
+	LayoutHeight = screen->GetHeight();
 
-void WolfStatusBar::DrawKeys (void)
-{
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Keys.Enabled) return;
-	static bool extendedKeysGraphics = TexMan.CheckForTexture("STKEYS3", FTexture::TEX_Any).isValid();
-	static bool emptyKeysGraphic = TexMan.CheckForTexture("STKEYS0", FTexture::TEX_Any).isValid();
+	StatusBarPic = TexMan.GetTexture("STBAR", FTexture::TEX_MiscPatch);
+	DeadFace = TexMan.GetTexture("STFDEAD0", FTexture::TEX_MiscPatch);
+	MutantFace = TexMan.GetTexture("STFMUT0", FTexture::TEX_MiscPatch);
+	for(unsigned int i = 0;i < 7;++i)
+	{
+		FString name;
+		name.Format("STKEYS%u", i);
+		KeyPics[i] = TexMan.CheckForTexture(name, FTexture::TEX_MiscPatch);
+	}
+	HudFont = V_GetFont("HudFont");
 
-	// Find keys in inventory
-	unsigned int presentKeys = 0;
-	if(players[ConsolePlayer].mo)
+	FTexture *stbar = TexMan(StatusBarPic);
+	Area.Clear();
+	if(stbar)
 	{
-		for(AInventory *item = players[ConsolePlayer].mo->inventory;item != NULL;item = item->inventory)
-		{
-			if(item->IsKindOf(NATIVE_CLASS(Key)))
-			{
-				unsigned int slot = static_cast<AKey *>(item)->KeyNumber;
-				if(slot <= 4)
-					presentKeys |= 1<<(slot-1);
-				if(presentKeys == 15)
-					break;
-			}
-		}
+		double x = 0, y = 160, w = stbar->GetScaledWidthDouble(), h = stbar->GetScaledHeightDouble();
+		screen->VirtualToRealCoords(x, y, w, h, 320, 200, true, true);
+		Area.x1 = MAX<int>(0, int(floor(x)));
+		Area.y1 = MAX<int>(0, int(floor(y)));
+		Area.x2 = MIN<int>(LayoutWidth, int(ceil(x+w)));
+		Area.y2 = MIN<int>(LayoutHeight, int(ceil(y+h)));
 	}
 
-	const unsigned int x = StatusBarConfig.Keys.X;
-	unsigned int y = StatusBarConfig.Keys.Y;
-	if (extendedKeysGraphics && (presentKeys & (1|4)) == (1|4))
-		StatusDrawPic (x,y,"STKEYS5");
-	else if(extendedKeysGraphics && (presentKeys & 4))
-		StatusDrawPic (x,y,"STKEYS3");
-	else if(presentKeys & 1)
-		StatusDrawPic (x,y,"STKEYS1");
-	else if(emptyKeysGraphic)
-		StatusDrawPic (x,y,"STKEYS0");
-
-	y += mac ? 20 : 16;
-	if (extendedKeysGraphics && (presentKeys & (2|8)) == (2|8))
-		StatusDrawPic (x,y,"STKEYS6");
-	else if (extendedKeysGraphics && (presentKeys & 8))
-		StatusDrawPic (x,y,"STKEYS4");
-	else if (presentKeys & 2)
-		StatusDrawPic (x,y,"STKEYS2");
-	else if (emptyKeysGraphic)
-		StatusDrawPic (x,y,"STKEYS0");
+	Background.Clear();
+	Composite.Clear();
+	if(Area.x1 < Area.x2 && Area.y1 < Area.y2)
+	{
+		VWB_DrawGraphic(stbar, 0, 160);
+		Background.Resize((Area.x2-Area.x1)*(Area.y2-Area.y1));
+		screen->GetBlock(Area.x1, Area.y1, Area.x2-Area.x1, Area.y2-Area.y1, &Background[0]);
+		Composite.Resize(Background.Size());
+	}
+	return true;
 }
 
-//===========================================================================
-
-/*
-===============
-=
-= DrawAmmo
-=
-===============
-*/
-
-void WolfStatusBar::DrawAmmo (void)
+void WolfStatusBar::RestoreBackground(const Box &box)
 {
-	if((viewsize == 21 && ingame) || !StatusBarConfig.Ammo.Enabled ||
-		!players[ConsolePlayer].ReadyWeapon || !players[ConsolePlayer].ReadyWeapon->ammo[AWeapon::PrimaryFire])
+	const int x1 = MAX(box.x1, Area.x1), x2 = MIN(box.x2, Area.x2);
+	const int y1 = MAX(box.y1, Area.y1), y2 = MIN(box.y2, Area.y2);
+	if(x1 >= x2 || y1 >= y2)
 		return;
 
-	unsigned int amount = players[ConsolePlayer].ReadyWeapon->ammo[AWeapon::PrimaryFire]->amount;
-	LatchNumber (StatusBarConfig.Ammo.X,StatusBarConfig.Ammo.Y,StatusBarConfig.Ammo.Digits,amount,mac,true);
+	const int width = Area.x2-Area.x1;
+	const BYTE *src = &Background[(y1-Area.y1)*width + (x1-Area.x1)];
+	BYTE *dest = screen->GetBuffer() + y1*screen->GetPitch() + x1;
+	for(int y = y1;y < y2;++y)
+	{
+		memcpy(dest, src, x2-x1);
+		src += width;
+		dest += screen->GetPitch();
+	}
 }
 
-//===========================================================================
-
-void WolfStatusBar::RefreshBackground(bool noborder)
+void WolfStatusBar::RedrawAll(const Element *state)
 {
-	DBaseStatusBar::RefreshBackground(noborder);
-
-	if(viewsize == 21 && ingame)
-		return;
+	if(Background.Size() == 0)
+		VWB_DrawGraphic(TexMan(StatusBarPic), 0, 160);
+	else
+		screen->DrawBlock(Area.x1, Area.y1, Area.x2-Area.x1, Area.y2-Area.y1, &Background[0]);
 
-	VWB_DrawGraphic(TexMan("STBACK"), 0, 160);
+	for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+	{
+		DrawElement(i, state[i]);
+		Elements[i] = state[i];
+	}
 }
 
 void WolfStatusBar::DrawStatusBar()
@@ -524,16 +627,73 @@ void WolfStatusBar::DrawStatusBar()
 	if(viewsize == 21 && ingame)
 		return;
 
-	VWB_DrawGraphic(TexMan("STBAR"), 0, 160);
-	DrawFace ();
-	DrawHealth ();
-	DrawLives ();
-	DrawLevel ();
-	DrawAmmo ();
-	DrawKeys ();
-	DrawWeapon ();
-	DrawScore ();
-	DrawItems ();
+	Element state[NUM_SB_ELEMENTS];
+	for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+		GetElement(i, state[i]);
+
+	screen->Lock(false);
+	if(UpdateLayout() || Composite.Size() == 0)
+		RedrawAll(state);
+	else
+	{
+		bool dirty[NUM_SB_ELEMENTS];
+		bool anyDirty = false;
+		for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+			anyDirty |= (dirty[i] = !(state[i] == Elements[i]));
+
+		screen->DrawBlock(Area.x1, Area.y1, Area.x2-Area.x1, Area.y2-Area.y1, &Composite[0]);
+		if(!anyDirty)
+		{
+			screen->Unlock();
+			return;
+		}
+
+		// Erasing an element may take part of an overlapping one with it.
+		for(bool grew = true;grew;)
+		{
+			grew = false;
+			for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+			{
+				if(!dirty[i])
+					continue;
+				for(unsigned int j = 0;j < NUM_SB_ELEMENTS;++j)
+				{
+					if(!dirty[j] && Boxes[i].Intersects(Boxes[j]))
+						dirty[j] = grew = true;
+				}
+			}
+		}
+
+		for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+		{
+			if(dirty[i])
+				RestoreBackground(Boxes[i]);
+		}
+
+		bool overlapped = false;
+		for(unsigned int i = 0;i < NUM_SB_ELEMENTS;++i)
+		{
+			if(!dirty[i])
+				continue;
+			DrawElement(i, state[i]);
+			Elements[i] = state[i];
+
+			for(unsigned int j = 0;j < NUM_SB_ELEMENTS;++j)
+			{
+				if(!dirty[j] && Boxes[i].Intersects(Boxes[j]))
+					overlapped = true;
+			}
+		}
+
+		// Something grew into an element we left alone, so the draw order
+		// could be off. Just start over.
+		if(overlapped)
+			RedrawAll(state);
+	}
+
+	if(Composite.Size() != 0)
+		screen->GetBlock(Area.x1, Area.y1, Area.x2-Area.x1, Area.y2-Area.y1, &Composite[0]);
+	screen->Unlock();
 }
 
 //===========================================================================
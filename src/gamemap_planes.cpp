@@ -890,16 +890,42 @@ void GameMap::ReadPlanesData()
 	TArray<MapTrigger> triggers;
 	TMap<WORD, TArray<MapSpot> > elevatorSpots;
 
-	// Read and store the info plane so we can reference it
-	WORD* infoplane = new WORD[size];
-	if(numPlanes > 3)
+	// Use the expanded planes in place if the lump is in memory, otherwise
+	// read them all at once.
+	const DWORD planesOffset = 18+nameLength;
+	TArray<WORD> planeStorage;
+	const WORD* planeData;
+	const char* buffer = lump->GetBuffer();
+#ifndef __BIG_ENDIAN__
+	if(buffer != NULL && (DWORD)lump->GetLength() >= planesOffset+size*2*numPlanes &&
+		((size_t)(buffer+planesOffset) & 1) == 0)
 	{
-		lump->Seek(size*2*3, SEEK_CUR);
-		lump->Read(infoplane, size*2);
-		lump->Seek(18+nameLength, SEEK_SET);
+		planeData = reinterpret_cast<const WORD*>(buffer+planesOffset);
 	}
 	else
-		memset(infoplane, 0, size*2);
+#endif
+	{
+		planeStorage.Resize(MAX<DWORD>(size*numPlanes, 1));
+		memset(&planeStorage[0], 0, planeStorage.Size()*2);
+		lump->Seek(planesOffset, SEEK_SET);
+		lump->Read(&planeStorage[0], size*2*numPlanes);
+		for(unsigned int i = 0;i < size*numPlanes;++i)
+			planeStorage[i] = LittleShort(planeStorage[i]);
+		planeData = &planeStorage[0];
+	}
+
+	// The info plane is referenced after the others, give maps without one
+	// an empty plane.
+	TArray<WORD> emptyInfo;
+	const WORD* infoplane;
+	if(numPlanes > 3)
+		infoplane = planeData + size*3;
+	else
+	{
+		emptyInfo.Resize(MAX<DWORD>(size, 1));
+		memset(&emptyInfo[0], 0, emptyInfo.Size()*2);
+		infoplane = &emptyInfo[0];
+	}
 
 	FTextureID defaultCeiling = levelInfo->DefaultTexture[Sector::Ceiling];
 	FTextureID defaultFloor = levelInfo->DefaultTexture[Sector::Floor];
@@ -909,8 +935,7 @@ void GameMap::ReadPlanesData()
 		if(plane == 3) // Info plane is already read
 			continue;
 
-		WORD* oldplane = new WORD[size];
-		lump->Read(oldplane, size*2);
+		const WORD* const oldplane = planeData + size*plane;
 
 		switch(plane)
 		{
@@ -928,8 +953,6 @@ void GameMap::ReadPlanesData()
 
 				for(unsigned int i = 0;i < size;++i)
 				{
-					oldplane[i] = LittleShort(oldplane[i]);
-
 					if(xlat.IsValidTile(oldplane[i]))
 						mapPlane.map[i].SetTile(&tilePalette[oldplane[i]-tileStart]);
 					else
@@ -1084,8 +1107,6 @@ void GameMap::ReadPlanesData()
 					i = 4;
 				for(;i < size;++i)
 				{
-					oldplane[i] = LittleShort(oldplane[i]);
-
 					if(oldplane[i] == 0)
 					{
 						// In case of malformed maps we need to always check this.
@@ -1186,8 +1207,6 @@ void GameMap::ReadPlanesData()
 				TMap<WORD, WORD> flatMap;
 				for(unsigned int i = 0;i < size;++i)
 				{
-					oldplane[i] = LittleShort(oldplane[i]);
-
 					if(!flatMap.CheckKey(oldplane[i]))
 						flatMap[oldplane[i]] = type++;
 				}
@@ -1209,7 +1228,6 @@ void GameMap::ReadPlanesData()
 				break;
 			}
 		}
-		delete[] oldplane;
 	}
 
 	SetupLinks();
@@ -1252,7 +1270,6 @@ void GameMap::ReadPlanesData()
 		if(trig.isSecret)
 			++gamestate.secrettotal;
 	}
-	delete[] infoplane;
 
 	// Install elevators
 	TMap<WORD, TArray<MapSpot> >::ConstIterator iter(elevatorSpots);
@@ -104,21 +104,186 @@ static  int                     sqHackLen;
 static  int                     sqHackSeqLen;
 static  longword                sqHackTime;
 
-static int musicchunk=-1;
 Mix_Music *music=NULL;
-TUniquePtr<byte[]> chunkmem;
+
+// Streams a music lump from its own handle to the archive so that it doesn't
+// need to be read into memory, and so that the mixer can read from it on
+// the audio thread.
+#if SDL_VERSION_ATLEAST(2,0,0)
+static Sint64 MusicStream_Size(SDL_RWops *ops)
+{
+	return (Sint64)((FileReader*)ops->hidden.unknown.data1)->GetLength();
+}
+static Sint64 MusicStream_Seek(SDL_RWops *ops, Sint64 pos, int relative)
+#else
+static int MusicStream_Seek(SDL_RWops *ops, int pos, int relative)
+#endif
+{
+	FileReader *reader = (FileReader*)ops->hidden.unknown.data1;
+	int origin;
+	switch(relative)
+	{
+		default:
+		case RW_SEEK_SET: origin = SEEK_SET; break;
+		case RW_SEEK_CUR: origin = SEEK_CUR; break;
+		case RW_SEEK_END: origin = SEEK_END; break;
+	}
+	if(reader->Seek((long)pos, origin) != 0)
+		return -1;
+	return reader->Tell();
+}
+#if SDL_VERSION_ATLEAST(2,0,0)
+static size_t MusicStream_Read(SDL_RWops *ops, void *buffer, size_t size, size_t nmem)
+#else
+static int MusicStream_Read(SDL_RWops *ops, void *buffer, int size, int nmem)
+#endif
+{
+	FileReader *reader = (FileReader*)ops->hidden.unknown.data1;
+	const long left = reader->GetLength() - reader->Tell();
+	if(size == 0 || left <= 0)
+		return 0;
+
+	const long want = (long)MIN<size_t>(size*nmem, left);
+	return reader->Read(buffer, want - want%size)/size;
+}
+static int MusicStream_Close(SDL_RWops *ops)
+{
+	delete (FileReader*)ops->hidden.unknown.data1;
+	SDL_FreeRW(ops);
+	return 0;
+}
+
+// A music lump opened for SDL_mixer. Loading parses the header and starts
+// decoding, which can take long enough to cause a hitch, so the track is
+// opened on the main thread and may be loaded on another one. Lumps which
+// the mixer doesn't recognize are IMF and are kept in data for the
+// sequencer.
+struct MusicTrack
+{
+	MusicTrack() : lumpNum(-1), length(0), music(NULL), source(NULL) {}
+
+	void Free()
+	{
+		if(music != NULL)
+		{
+			Mix_FreeMusic(music);
+			music = NULL;
+		}
+		if(source != NULL)
+		{
+			SDL_RWclose(source);
+			source = NULL;
+		}
+		data.Reset();
+		lumpNum = -1;
+	}
+
+	void Open(int lump)
+	{
+		lumpNum = lump;
+		length = Wads.LumpLength(lump);
+
+		// Archives in memory can be played from in place.
+		const char *stored = Wads.GetStoredLumpData(lump);
+		if(stored != NULL)
+		{
+			source = SDL_RWFromConstMem(stored, length);
+			return;
+		}
+
+		FileReader *reader = Wads.ReopenLumpNumNewFile(lump);
+		if(reader != NULL)
+		{
+			source = SDL_AllocRW();
+#if SDL_VERSION_ATLEAST(2,0,0)
+			source->size = MusicStream_Size;
+#endif
+			source->seek = MusicStream_Seek;
+			source->read = MusicStream_Read;
+			source->write = NULL;
+			source->close = MusicStream_Close;
+			source->type = 0;
+			source->hidden.unknown.data1 = reader;
+		}
+		else
+		{
+			// Compressed, so it has to be read in anyway.
+			data = new byte[length];
+			Wads.ReadLump(lump, data.Get());
+			source = SDL_RWFromMem(data.Get(), length);
+		}
+	}
+
+	// Doesn't touch anything but the track, so may be called from any thread.
+	void Load()
+	{
+#if defined(ECWOLF_MIXER) || SDL_VERSION_ATLEAST(2,0,0)
+		music = Mix_LoadMUS_RW(source, false);
+#else
+		music = Mix_LoadMUS_RW(source);
+#endif
+		if(music != NULL)
+			return;
+
+		if(data == NULL)
+		{
+			data = new byte[length];
+			SDL_RWseek(source, 0, RW_SEEK_SET);
+			SDL_RWread(source, data.Get(), 1, length);
+		}
+		SDL_RWclose(source);
+		source = NULL;
+	}
+
+	void Swap(MusicTrack &other)
+	{
+		swapvalues(lumpNum, other.lumpNum);
+		swapvalues(length, other.length);
+		swapvalues(music, other.music);
+		swapvalues(source, other.source);
+		data.Swap(other.data);
+	}
+
+	int lumpNum;
+	int length;
+	Mix_Music *music;
+	SDL_RWops *source;
+	TUniquePtr<byte[]> data;
+};
+
+// musicTrack is what music was loaded from. The track played before it is
+// kept so that alternating between two songs, such as the level and the
+// intermission, doesn't load either again.
+static MusicTrack musicTrack, lastTrack, prefetchTrack;
+static SDL_Thread *prefetchThread;
+
+static int SD_PrefetchThread(void *data)
+{
+	static_cast<MusicTrack*>(data)->Load();
+	return 0;
+}
+
+// Waits for the prefetch in progress, if any. Not every decoder in the
+// mixer can load two songs at once so this is also done before loading
+// anything on the main thread.
+static void SD_WaitPrefetch()
+{
+	if(prefetchThread != NULL)
+	{
+		SDL_WaitThread(prefetchThread, NULL);
+		prefetchThread = NULL;
+	}
+}
 
 void musicFinished(void)
 {
 	if (music != NULL)
 	{
-		Mix_HaltMusic();
-		Mix_FreeMusic(music);
+		// Clear music first since halting calls back into here.
 		music = NULL;
+		Mix_HaltMusic();
 
-		chunkmem.Reset();
-
-		musicchunk = -1;
+		musicTrack.Free();
 	}
 }
 
@@ -578,6 +743,10 @@ static int MacSound_Close(SDL_RWops *ops)
 
 Mix_Chunk* SD_PrepareSound(int which)
 {
+	// Nothing to convert the sound for without a device
+	if(!SD_Started)
+		return NULL;
+
 	int size = Wads.LumpLength(which);
 	if(size == 0)
 		return NULL;
@@ -1030,28 +1199,24 @@ void SDL_IMFMusicPlayer(void *udata, Uint8 *stream, int len)
 
 ///////////////////////////////////////////////////////////////////////////
 //
-//      SD_Startup() - starts up the Sound Mgr
-//              Detects all additional sound hardware and installs my ISR
+//      SD_OpenAudio() - Opens the audio device and starts the music hook
 //
 ///////////////////////////////////////////////////////////////////////////
-void
-SD_Startup(void)
+static bool
+SD_OpenAudio(void)
 {
 	int     i;
 
-	if (SD_Started)
-		return;
-
 	if(SDL_InitSubSystem(SDL_INIT_AUDIO) != 0)
 	{
 		Printf("Unable to initialize audio.\n");
-		return;
+		return false;
 	}
 
 	if((audioMutex = SDL_CreateMutex()) == NULL)
 	{
 		printf("Unable to create audio mutex\n");
-		return;
+		return false;
 	}
 
 #if defined(__ANDROID__)
@@ -1064,7 +1229,7 @@ SD_Startup(void)
 	if(Mix_OpenAudio(param_samplerate, AUDIO_S16, 2, param_audiobuffer))
 	{
 		printf("Unable to open audio: %s\n", Mix_GetError());
-		return;
+		return false;
 	}
 	atterm(Mix_CloseAudio);
 
@@ -1096,11 +1261,30 @@ SD_Startup(void)
 	SoundBlasterPresent = true;
 
 	alTimeCount = 0;
+	return true;
+}
 
-	SD_SetSoundMode(sdm_Off);
-	SD_SetMusicMode(smm_Off);
+///////////////////////////////////////////////////////////////////////////
+//
+//      SD_Startup() - starts up the Sound Mgr
+//              Detects all additional sound hardware and installs my ISR
+//
+///////////////////////////////////////////////////////////////////////////
+void
+SD_Startup(void)
+{
+	if (SD_Started)
+		return;
 
-	SD_Started = true;
+	// Headless runs don't open a device, but sounds are still looked up by
+	// name so the definitions must always be read.
+	if(!param_headless && SD_OpenAudio())
+	{
+		SD_SetSoundMode(sdm_Off);
+		SD_SetMusicMode(smm_Off);
+
+		SD_Started = true;
+	}
 
 	SoundInfo.Init();
 	SoundSeq.Init();
@@ -1121,6 +1305,11 @@ SD_Shutdown(void)
 	SD_MusicOff();
 	SD_StopSound();
 
+	SD_WaitPrefetch();
+	musicFinished();
+	lastTrack.Free();
+	prefetchTrack.Free();
+
 	if(audioMutex != NULL)
 	{
 		SDL_DestroyMutex(audioMutex);
@@ -1370,6 +1559,86 @@ SD_MusicOff(void)
 	return musoffs;
 }
 
+///////////////////////////////////////////////////////////////////////////
+//
+//      SD_PrefetchMusic() - starts loading a song in the background so that
+//              a later SD_StartMusic can start it right away
+//
+///////////////////////////////////////////////////////////////////////////
+void
+SD_PrefetchMusic(const char* chunk)
+{
+	if (MusicMode != smm_AdLib)
+		return;
+
+	int lumpNum = Wads.CheckNumForName(chunk, ns_music);
+	if(lumpNum == -1 || lumpNum == prefetchTrack.lumpNum ||
+		(music != NULL && lumpNum == musicTrack.lumpNum) || lumpNum == lastTrack.lumpNum)
+		return;
+
+	SD_WaitPrefetch();
+	prefetchTrack.Free();
+	prefetchTrack.Open(lumpNum);
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+	prefetchThread = SDL_CreateThread(SD_PrefetchThread, "MusicPrefetch", &prefetchTrack);
+#else
+	prefetchThread = SDL_CreateThread(SD_PrefetchThread, &prefetchTrack);
+#endif
+	// Without a thread just load it now.
+	if(prefetchThread == NULL)
+		prefetchTrack.Load();
+}
+
+// Makes the given lump the current track, taking it from the last or
+// prefetched track if possible. If it's an IMF then music is left NULL and
+// the lump is in musicTrack.data.
+static void SD_SwitchTrack(int lumpNum)
+{
+	if(music != NULL && musicTrack.lumpNum == lumpNum)
+		return;
+
+	MusicTrack outgoing;
+	if(music != NULL)
+	{
+		// Stop it without musicFinished freeing it.
+		music = NULL;
+		Mix_HaltMusic();
+		outgoing.Swap(musicTrack);
+	}
+	musicTrack.Free();
+
+	if(lastTrack.lumpNum == lumpNum)
+		musicTrack.Swap(lastTrack);
+	else
+	{
+		SD_WaitPrefetch();
+		if(prefetchTrack.lumpNum == lumpNum)
+			musicTrack.Swap(prefetchTrack);
+		else
+		{
+			musicTrack.Open(lumpNum);
+			musicTrack.Load();
+		}
+	}
+
+	if(outgoing.music != NULL)
+		lastTrack.Swap(outgoing);
+	outgoing.Free();
+
+	music = musicTrack.music;
+}
+
+// Hands an IMF in musicTrack over to the sequencer. audioMutex must be held.
+static void SD_SetupIMF()
+{
+	sqHack = reinterpret_cast<word*>(musicTrack.data.Release());
+	sqHackFreeable = sqHack;
+	if(*sqHack == 0) sqHackLen = sqHackSeqLen = musicTrack.length;
+	else sqHackLen = sqHackSeqLen = LittleShort(*sqHack++);
+	sqHackPtr = sqHack;
+}
+
 ///////////////////////////////////////////////////////////////////////////
 //
 //      SD_StartMusic() - starts playing the music pointed to
@@ -1397,20 +1666,7 @@ SD_StartMusic(const char* chunk)
 		if(lumpNum == -1)
 			return;
 
-		// Load our music file from chunk
-		chunkmem = new byte[Wads.LumpLength(lumpNum)];
-		FWadLump lump = Wads.OpenLumpNum(lumpNum);
-		lump.Read(chunkmem.Get(), Wads.LumpLength(lumpNum));
-		SDL_RWops *mus_cunk = SDL_RWFromMem(chunkmem.Get(), Wads.LumpLength(lumpNum));
-
-		if(music)
-			Mix_FreeMusic(music);
-		// Technically an SDL_mixer 2 feature to free the source
-#if defined(ECWOLF_MIXER) || SDL_VERSION_ATLEAST(2,0,0)
-		music = Mix_LoadMUS_RW(mus_cunk, true);
-#else
-		music = Mix_LoadMUS_RW(mus_cunk);
-#endif
+		SD_SwitchTrack(lumpNum);
 
 		// We assume that when music equals to NULL, we've an IMF file to play
 		if (music == NULL)
@@ -1422,11 +1678,7 @@ SD_StartMusic(const char* chunk)
 			for (int i = 0;i < OPL_CHANNELS;++i)
 				SDL_AlSetChanInst(&ChannelRelease, i);
 
-			sqHack = reinterpret_cast<word*>(chunkmem.Release());
-			sqHackFreeable = sqHack;
-			if(*sqHack == 0) sqHackLen = sqHackSeqLen = Wads.LumpLength(lumpNum);
-			else sqHackLen = sqHackSeqLen = LittleShort(*sqHack++);
-			sqHackPtr = sqHack;
+			SD_SetupIMF();
 			sqHackTime = 0;
 			alTimeCount = 0;
 
@@ -1441,7 +1693,6 @@ SD_StartMusic(const char* chunk)
 			SDL_LockMutex(audioMutex);
 
 			// Play the music
-			musicchunk = lumpNum;
 			if (Mix_PlayMusic(music, -1) == -1)
 			{
 				printf("Unable to play music file: %s\n", Mix_GetError());
@@ -1474,33 +1725,14 @@ SD_ContinueMusic(const char* chunk, int startoffs)
 		if(lumpNum == -1)
 			return;
 
-		if (music == NULL || musicchunk != lumpNum)
-		{ // We need this scope to "delete" the lump before modifying the sqHack pointers.
-			SDL_LockMutex(audioMutex);
-			FWadLump lump = Wads.OpenLumpNum(lumpNum);
-			sqHackFreeable.Reset();
-
-			// Load our music file from chunk
-			chunkmem = new byte[Wads.LumpLength(lumpNum)];
-			lump.Read(chunkmem.Get(), Wads.LumpLength(lumpNum));
-			SDL_RWops *mus_cunk = SDL_RWFromMem(chunkmem.Get(), Wads.LumpLength(lumpNum));
-#if defined(ECWOLF_MIXER) || SDL_VERSION_ATLEAST(2,0,0)
-			music = Mix_LoadMUS_RW(mus_cunk, true);
-#else
-			music = Mix_LoadMUS_RW(mus_cunk);
-#endif
-			if (music == NULL)
-			{
-				sqHack = reinterpret_cast<word*>(chunkmem.Release());
-				sqHackFreeable = sqHack;
-				if(*sqHack == 0) sqHackLen = sqHackSeqLen = Wads.LumpLength(lumpNum);
-				else sqHackLen = sqHackSeqLen = LittleShort(*sqHack++);
-				sqHackPtr = sqHack;
-			}
-		}
+		const bool paused = music != NULL && musicTrack.lumpNum == lumpNum;
+		SD_SwitchTrack(lumpNum);
 
 		if (music == NULL)
 		{
+			SDL_LockMutex(audioMutex);
+
+			SD_SetupIMF();
 			if(startoffs >= sqHackLen)
 			{
 				SDL_UnlockMutex(audioMutex);
@@ -1532,18 +1764,15 @@ SD_ContinueMusic(const char* chunk, int startoffs)
 		}
 		else
 		{
-			SDL_UnlockMutex(audioMutex);
-
 			Mix_HookMusic(0, 0);
 
-			if (Mix_PausedMusic() == 1 && musicchunk == lumpNum)
+			if (paused && Mix_PausedMusic() == 1)
 			{
 				Mix_ResumeMusic();
 				return;
 			}
 
 			// Play the music
-			musicchunk = lumpNum;
 			if (Mix_PlayMusic(music, -1) == -1)
 			{
 				printf("Unable to play music file: %s\n", Mix_GetError());
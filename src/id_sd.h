@@ -161,6 +161,7 @@ extern  void    SD_StopSound(void),
 				SD_WaitSoundDone(void);
 
 extern  void    SD_StartMusic(const char* chunk);
+extern  void    SD_PrefetchMusic(const char* chunk);
 extern  int     SD_PauseMusic(void);
 extern  void    SD_ContinueMusic(const char* chunk, int startoffs);
 extern  void    SD_MusicOn(void),
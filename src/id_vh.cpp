@@ -1,5 +1,6 @@
 #include "wl_def.h"
 #include "am_map.h"
+#include "dobject.h"
 #include "id_sd.h"
 #include "id_in.h"
 #include "id_vl.h"
@@ -150,6 +151,7 @@ void VH_UpdateScreen()
 {
 	screen->Update();
 	screen->Lock(false);
+	GC::EndFrame();
 }
 
 /*
@@ -44,6 +44,14 @@ static inline void WriteLittleShort(BYTE * const ptr, WORD value)
 	ptr[1] = (value>>8)&0xFF;
 }
 
+static inline void WriteLittleLong(BYTE * const ptr, DWORD value)
+{
+	ptr[0] = value&0xFF;
+	ptr[1] = (value>>8)&0xFF;
+	ptr[2] = (value>>16)&0xFF;
+	ptr[3] = (value>>24)&0xFF;
+}
+
 
 // Now for some writing
 // Syntax: char data[x] = {WRITEINT32_DIRECT(integer),WRITEINT32_DIRECT(integer)...}
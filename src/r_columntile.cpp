@@ -0,0 +1,136 @@
+/*
+** r_columntile.cpp
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include <climits>
+#include <string.h>
+
+#include "r_columntile.h"
+
+void FColumnTile::Begin(byte *dest, unsigned int pitch, int width, int height)
+{
+	Dest = dest;
+	Pitch = pitch;
+	Width = width;
+	X = 0;
+	if(Data.Size() < unsigned(height*WIDTH))
+		Data.Resize(height*WIDTH);
+	for(unsigned int i = 0;i < WIDTH;++i)
+		Spans[i].Clear();
+}
+
+void FColumnTile::DrawColumn(int slot, int top, int bottom)
+{
+	const BYTE *src = &Data[top*WIDTH + slot];
+	byte *dest = Dest + top*Pitch + X + slot;
+	for(int count = bottom - top + 1;count > 0;--count)
+	{
+		*dest = *src;
+		src += WIDTH;
+		dest += Pitch;
+	}
+}
+
+void FColumnTile::Flush()
+{
+	unsigned int cur[WIDTH] = {0};
+	const bool wide = X+WIDTH <= Width;
+
+	for(;;)
+	{
+		int live = 0, maxtop = 0, minbot = INT_MAX, minslot = 0;
+		for(int i = 0;i < WIDTH;++i)
+		{
+			if(cur[i] >= Spans[i].Size())
+				continue;
+
+			const Span &span = Spans[i][cur[i]];
+			++live;
+			if(span.top > maxtop)
+				maxtop = span.top;
+			if(span.bottom < minbot)
+			{
+				minbot = span.bottom;
+				minslot = i;
+			}
+		}
+
+		if(live == 0)
+			break;
+
+		// Spans which can't line up with one in every other column are
+		// drawn on their own.
+		if(live < WIDTH || !wide)
+		{
+			for(int i = 0;i < WIDTH;++i)
+			{
+				for(;cur[i] < Spans[i].Size();++cur[i])
+					DrawColumn(i, Spans[i][cur[i]].top, Spans[i][cur[i]].bottom);
+			}
+			break;
+		}
+		if(maxtop > minbot)
+		{
+			DrawColumn(minslot, Spans[minslot][cur[minslot]].top, minbot);
+			++cur[minslot];
+			continue;
+		}
+
+		// Draw anything above the shared rows, then the shared rows.
+		for(int i = 0;i < WIDTH;++i)
+		{
+			if(Spans[i][cur[i]].top < maxtop)
+				DrawColumn(i, Spans[i][cur[i]].top, maxtop-1);
+		}
+
+		const BYTE *src = &Data[maxtop*WIDTH];
+		byte *dest = Dest + maxtop*Pitch + X;
+		for(int count = minbot - maxtop + 1;count > 0;--count)
+		{
+			memcpy(dest, src, WIDTH);
+			src += WIDTH;
+			dest += Pitch;
+		}
+
+		for(int i = 0;i < WIDTH;++i)
+		{
+			Span &span = Spans[i][cur[i]];
+			if(span.bottom > minbot)
+				span.top = minbot+1;
+			else
+				++cur[i];
+		}
+	}
+
+	for(unsigned int i = 0;i < WIDTH;++i)
+		Spans[i].Clear();
+}
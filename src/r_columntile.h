@@ -0,0 +1,107 @@
+/*
+** r_columntile.h
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Transposed buffer for drawing four adjacent screen columns at once.
+**
+*/
+
+#ifndef __R_COLUMNTILE_H__
+#define __R_COLUMNTILE_H__
+
+#include "wl_def.h"
+#include "tarray.h"
+
+// Drawing straight down a column touches a new cache line for every pixel,
+// which is what dominates at high resolutions. Columns are instead drawn
+// into a small buffer with four bytes per row and the rows all four share
+// are written out with a single store each, the same idea the rt_ drawers
+// use for the 2D path.
+//
+// Columns must be visited left to right. A column outside the current tile
+// flushes it first.
+//
+// There's no SSE2/AVX2 path picked with V_PfxPathAvailable as v_pfx.cpp
+// does. A shared row is a single 4 byte store and every row is its own
+// cache line, so vector stores only help with a tile as wide as a vector.
+// 16 and 32 column tiles flushed with one SSE2 or AVX2 store per row were
+// no faster than this WIDTH column tile with its one 4 byte store at
+// 2560x1440, since the time goes to touching a line per row rather than to
+// the stores.
+class FColumnTile
+{
+public:
+	enum { WIDTH = 4 };
+
+	FColumnTile() : Dest(NULL), Pitch(0), Width(0), X(0) {}
+
+	// Sets the view which is drawn to. Nothing is kept between views.
+	void Begin(byte *dest, unsigned int pitch, int width, int height);
+	void Flush();
+
+	// Returns where row 0 of screen column x goes. Rows are WIDTH bytes apart.
+	BYTE *Column(int x)
+	{
+		if(x < X || x >= X+WIDTH || Spans[x-X].Size() != 0)
+		{
+			Flush();
+			X = x & ~(WIDTH-1);
+		}
+		return &Data[x-X];
+	}
+
+	// Records that rows top through bottom of column x were written. Spans in
+	// a column must be added top to bottom.
+	void AddSpan(int x, int top, int bottom)
+	{
+		if(top > bottom)
+			return;
+		Span &span = Spans[x-X][Spans[x-X].Reserve(1)];
+		span.top = top;
+		span.bottom = bottom;
+	}
+
+private:
+	struct Span
+	{
+		int top, bottom;
+	};
+
+	void DrawColumn(int slot, int top, int bottom);
+
+	byte *Dest;
+	unsigned int Pitch;
+	int Width;
+	int X;
+	TArray<BYTE> Data;
+	TArray<Span> Spans[WIDTH];
+};
+
+#endif
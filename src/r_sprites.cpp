@@ -34,6 +34,7 @@
 
 #include "textures/textures.h"
 #include "c_cvars.h"
+#include "r_columntile.h"
 #include "r_sprites.h"
 #include "linkedlist.h"
 #include "tarray.h"
@@ -379,6 +380,54 @@ extern unsigned vbufPitch;
 extern fixed viewshift;
 extern fixed viewz;
 
+// Returns the first sprite row which samples at or below the given texel
+// row, ie. the smallest r where r*yStep >= texel<<FRACBITS.
+static inline unsigned int R_SpriteRowForTexel(unsigned int texel, fixed yStep)
+{
+	return static_cast<unsigned int>(((static_cast<QWORD>(texel)<<FRACBITS) + yStep - 1)/yStep);
+}
+
+// Columns which don't share a texel column are gathered here.
+static FColumnTile SpriteTile;
+
+// Draws the rows [startY, endY) of a sprite column by walking its spans so
+// transparent runs are skipped without testing each pixel. dest points to
+// the pixel for row startY and rows are pitch bytes apart. With Columns > 1
+// the same texel column is written to that many adjacent screen columns at
+// once, which happens whenever a sprite is magnified. When drawing into the
+// sprite tile, tileX and tileRow give the screen column and row of dest so
+// the spans can be recorded.
+template<unsigned int Columns>
+static void R_DrawSpriteSpans(byte *dest, unsigned int pitch, const BYTE *src, const FTexture::Span *span,
+	fixed yStep, unsigned int startY, unsigned int endY, const BYTE *colormap, int tileX=-1, int tileRow=0)
+{
+	for(;span->Length;++span)
+	{
+		unsigned int row = R_SpriteRowForTexel(span->TopOffset, yStep);
+		if(row >= endY)
+			break;
+		unsigned int rowEnd = MIN(R_SpriteRowForTexel(span->TopOffset + span->Length, yStep), endY);
+		if(row < startY)
+			row = startY;
+		if(row >= rowEnd)
+			continue;
+
+		byte *d = dest + (row - startY)*pitch;
+		fixed y = row*yStep;
+		for(unsigned int count = rowEnd - row;count;--count)
+		{
+			const BYTE color = colormap[src[y>>FRACBITS]];
+			for(unsigned int c = 0;c < Columns;++c)
+				d[c] = color;
+			d += pitch;
+			y += yStep;
+		}
+
+		if(tileX >= 0)
+			SpriteTile.AddSpan(tileX, tileRow + (row - startY), tileRow + (rowEnd - 1 - startY));
+	}
+}
+
 void ScaleSprite(AActor *actor, int xcenter, const Frame *frame, unsigned height)
 {
 	// height is a 13.3 fixed point number indicating the number of screen
@@ -430,29 +479,61 @@ void ScaleSprite(AActor *actor, int xcenter, const Frame *frame, unsigned height
 		colormap = NormalLight.Maps;
 	else
 	{
-		const int shade = LIGHT2SHADE(gLevelLight + r_extralight);
-		const int tz = FixedMul(r_depthvisibility<<8, height);
-		colormap = &NormalLight.Maps[GETPALOOKUP(MAX(tz, MINZ), shade)<<8];
+		colormap = R_DepthColormap(height);
 	}
+	// Rows are sampled at r*yStep for r in [startY, endY).
+	if(yRun <= 0)
+		return;
+	const unsigned int endY = static_cast<unsigned int>((yRun + yStep - 1)/yStep);
+	if(endY <= startY)
+		return;
+
 	const BYTE *src;
-	byte *destBase = vbuf + actx + startX + ((upperedge>>3) > 0 ? vbufPitch*(upperedge>>3) : 0);
-	byte *dest = destBase;
+	const FTexture::Span *spans;
+	const int startRow = (upperedge>>3) > 0 ? (upperedge>>3) : 0;
+	byte *destBase = vbuf + actx + startX + vbufPitch*startRow;
 	unsigned int i;
-	fixed x, y;
-	for(i = actx+startX, x = startX*xStep;x < xRun;x += xStep, ++i, dest = ++destBase)
+	fixed x;
+	SpriteTile.Begin(vbuf, vbufPitch, viewwidth, viewheight);
+	for(i = actx+startX, x = startX*xStep;x < xRun;)
 	{
 		if(wallheight[i] > (signed)height)
+		{
+			x += xStep;
+			++i;
+			++destBase;
 			continue;
+		}
 
-		src = tex->GetColumn(flip ? texWidth - (x>>FRACBITS) - 1 : (x>>FRACBITS), NULL);
+		// Gather up to four visible columns which sample the same texel
+		// column so they can share one pass over the spans.
+		const unsigned int texCol = x>>FRACBITS;
+		unsigned int count = 1;
+		fixed nx = x + xStep;
+		while(count < 4 && nx < xRun && unsigned(nx>>FRACBITS) == texCol && wallheight[i+count] <= (signed)height)
+		{
+			++count;
+			nx += xStep;
+		}
 
-		for(y = startY*yStep;y < yRun;y += yStep)
+		src = tex->GetColumn(flip ? texWidth - texCol - 1 : texCol, &spans);
+
+		if(count == 4)
+			R_DrawSpriteSpans<4>(destBase, vbufPitch, src, spans, yStep, startY, endY, colormap);
+		else
 		{
-			if(src[y>>FRACBITS])
-				*dest = colormap[src[y>>FRACBITS]];
-			dest += vbufPitch;
+			for(unsigned int c = 0;c < count;++c)
+			{
+				BYTE *column = SpriteTile.Column(i+c) + startRow*FColumnTile::WIDTH;
+				R_DrawSpriteSpans<1>(column, FColumnTile::WIDTH, src, spans, yStep, startY, endY, colormap, i+c, startRow);
+			}
 		}
+
+		x = nx;
+		i += count;
+		destBase += count;
 	}
+	SpriteTile.Flush();
 }
 
 void Scale3DSpriter(AActor *actor, int x1, int x2, FTexture *tex, bool flip, const Frame *frame, fixed ny1, fixed ny2, fixed nx1, fixed nx2)
@@ -485,9 +566,7 @@ void Scale3DSpriter(AActor *actor, int x1, int x2, FTexture *tex, bool flip, con
 		colormap = NormalLight.Maps;
 	else
 	{
-		const int shade = LIGHT2SHADE(gLevelLight + r_extralight);
-		const int tz = FixedMul(r_depthvisibility<<8, height);
-		colormap = &NormalLight.Maps[GETPALOOKUP(MAX(tz, MINZ), shade)<<8];
+		colormap = R_DepthColormap(height);
 	}
 	const BYTE *src;
 
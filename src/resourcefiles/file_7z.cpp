@@ -174,6 +174,9 @@ struct F7ZLump : public FResourceLump
 	int		Position;
 
 	virtual int FillCache();
+	// The archive decompresses whole solid blocks at a time so extracting
+	// in order means each block is only done once.
+	virtual int GetSerialOrder() const { return Position; }
 
 };
 
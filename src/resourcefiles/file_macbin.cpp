@@ -152,6 +152,7 @@ struct FMacResLump : FResourceLump
 	int	Position;
 
 	int GetFileOffset() { return Position; }
+	bool IsStored() const { return Compressed == MODE_Uncompressed; }
 	FileReader *GetReader()
 	{
 		if(!Compressed)
@@ -165,12 +166,12 @@ struct FMacResLump : FResourceLump
 	{
 		if(!Compressed)
 		{
-			const char * buffer = Owner->Reader->GetBuffer();
+			const char * buffer = Owner->GetBufferRange(Position, LumpSize);
 
 			if (buffer != NULL)
 			{
 				// This is an in-memory file so the cache can point directly to the file's data.
-				Cache = const_cast<char*>(buffer) + Position;
+				Cache = const_cast<char*>(buffer);
 				RefCount = -1;
 				return -1;
 			}
@@ -78,6 +78,7 @@ struct FRFFLump : public FUncompressedLump
 	DWORD		IndexNum;
 
 	int GetIndexNum() const { return IndexNum; }
+	bool IsStored() const { return !(Flags & LUMPF_BLOODCRYPT); }
 };
 
 //==========================================================================
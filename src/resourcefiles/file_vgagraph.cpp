@@ -37,16 +37,11 @@
 #include "wl_def.h"
 #include "m_swap.h"
 #include "resourcefile.h"
+#include "huffman.h"
 #include "w_wad.h"
 #include "lumpremap.h"
 #include "zstring.h"
 
-struct Huffnode
-{
-	public:
-		WORD	bit0, bit1;	// 0-255 is a character, > is a pointer to a node
-};
-
 struct Dimensions
 {
 	public:
@@ -60,7 +55,7 @@ struct FVGALump : public FResourceLump
 	public:
 		DWORD		position;
 		DWORD		length;
-		Huffnode*	huffman;
+		const FHuffmanDecoder*	huffman;
 
 		bool		isImage;
 		bool		noSkip;
@@ -68,82 +63,35 @@ struct FVGALump : public FResourceLump
 
 		int FillCache()
 		{
-			Owner->Reader->Seek(position+(noSkip ? 0 : 4), SEEK_SET);
+			const DWORD start = position+(noSkip ? 0 : 4);
 
-			byte* data = new byte[length];
-			byte* out = new byte[LumpSize];
-			memset(out, 0, LumpSize);
-			Owner->Reader->Read(data, length);
-			HuffExpand(data, out);
-			delete[] data;
+			// Decode straight into the cache, from the file's memory if
+			// it's there.
+			const byte* data = (const byte*)Owner->GetBufferRange(start, length);
+			byte* temp = NULL;
+			if(data == NULL)
+			{
+				data = temp = new byte[length];
+				Owner->Reader->Seek(start, SEEK_SET);
+				Owner->Reader->Read(temp, length);
+			}
 
 			Cache = new char[LumpSize];
-			if(!isImage)
-				memcpy(Cache, out, LumpSize);
-			else
+			memset(Cache, 0, LumpSize);
+			byte* out = (byte*)Cache;
+			if(isImage)
 			{
 				// We flip again on big endian so that the code that reads the data makes sense
 				*(WORD*)Cache = LittleShort(dimensions.width);
 				*((WORD*)(Cache+2)) = LittleShort(dimensions.height);
-				memcpy(Cache+4, out, LumpSize-4);
+				out += 4;
 			}
-			delete[] out;
+			huffman->Expand(data, length, out, LumpSize - (DWORD)(out - (byte*)Cache));
+			delete[] temp;
 
 			RefCount = 1;
 			return 1;
 		}
-
-		byte *HuffExpand(byte* source, byte* dest)
-		{
-			byte *end, *send;
-			Huffnode *headptr, *huffptr;
-		
-			if(!LumpSize || !dest)
-			{
-				Quit("length or dest is null!");
-				return NULL;
-			}
-		
-			headptr = huffman+254;        // head node is always node 254
-		
-			int written = 0;
-		
-			end=dest+LumpSize;
-			send=source+length;
-
-			byte val = *source++;
-			byte mask = 1;
-			word nodeval;
-			huffptr = headptr;
-			while(1)
-			{
-				if(!(val & mask))
-					nodeval = huffptr->bit0;
-				else
-					nodeval = huffptr->bit1;
-				if(mask==0x80)
-				{
-					val = *source++;
-					mask = 1;
-					if(source>=send) break;
-				}
-				else mask <<= 1;
-			
-				if(nodeval<256)
-				{
-					*dest++ = (byte) nodeval;
-					written++;
-					huffptr = headptr;
-					if(dest>=end) break;
-				}
-				else
-				{
-					huffptr = huffman + (nodeval - 256);
-				}
-			}
-
-			return dest;
-		}
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -213,6 +161,7 @@ class FVGAGraph : public FResourceFile
 				huffman[i].bit0 = LittleShort(huffman[i].bit0);
 				huffman[i].bit1 = LittleShort(huffman[i].bit1);
 			}
+			decoder.Init(huffman);
 
 			NumLumps = vgaheadReader->GetLength()/3;
 			vgaheadReader->Seek(0, SEEK_SET);
@@ -236,7 +185,7 @@ class FVGAGraph : public FResourceFile
 				lumps[i].isImage = (i > numFonts+2 && i-numFonts-1 < numPictures);
 				lumps[i].Namespace = lumps[i].isImage ? ns_graphics : ns_global;
 				lumps[i].position = ReadLittle24(&data[i*3]);
-				lumps[i].huffman = huffman;
+				lumps[i].huffman = &decoder;
 
 				// The actual length isn't stored so we need to go by the position of the following lump.
 				lumps[i].length = 0;
@@ -265,7 +214,7 @@ class FVGAGraph : public FResourceFile
 					byte* data = new byte[lumps[0].length];
 					byte* out = new byte[lumps[0].LumpSize];
 					Reader->Read(data, lumps[0].length);
-					byte* endPtr = lumps[0].HuffExpand(data, out);
+					byte* endPtr = decoder.Expand(data, lumps[0].length, out, lumps[0].LumpSize);
 					delete[] data;
 
 					lumps[0].LumpSize = (unsigned int)(endPtr - out);
@@ -296,7 +245,7 @@ class FVGAGraph : public FResourceFile
 						byte* data = new byte[lumps[i-1].length];
 						byte* out = new byte[lumps[i-1].LumpSize];
 						Reader->Read(data, lumps[i-1].length);
-						byte* endPtr = lumps[i-1].HuffExpand(data, out);
+						decoder.Expand(data, lumps[i-1].length, out, lumps[i-1].LumpSize);
 						delete[] data;
 
 						bool endhit = false;
@@ -351,7 +300,7 @@ class FVGAGraph : public FResourceFile
 				byte* out = new byte[64*256];
 				Reader->Seek(lumps[tile8Position].position, SEEK_SET);
 				Reader->Read(data, lumps[tile8Position].length);
-				byte* endPtr = lumps[tile8Position].HuffExpand(data, out);
+				byte* endPtr = decoder.Expand(data, lumps[tile8Position].length, out, MIN<DWORD>(lumps[tile8Position].LumpSize, 64*256));
 				delete[] data;
 				delete[] out;
 
@@ -377,7 +326,8 @@ class FVGAGraph : public FResourceFile
 		}
 
 	private:
-		Huffnode	huffman[255];
+		Huffnode	huffman[FHuffmanDecoder::NUM_NODES];
+		FHuffmanDecoder	decoder;
 		FVGALump*	lumps;
 
 		FString		extension;
@@ -57,6 +57,7 @@ public:
 	int	Position;
 
 	int GetFileOffset() { return Position; }
+	bool IsStored() const { return !Compressed; }
 	FileReader *GetReader()
 	{
 		if(!Compressed)
@@ -70,12 +71,12 @@ public:
 	{
 		if(!Compressed)
 		{
-			const char * buffer = Owner->Reader->GetBuffer();
+			const char * buffer = Owner->GetBufferRange(Position, LumpSize);
 
 			if (buffer != NULL)
 			{
 				// This is an in-memory file so the cache can point directly to the file's data.
-				Cache = const_cast<char*>(buffer) + Position;
+				Cache = const_cast<char*>(buffer);
 				RefCount = -1;
 				return -1;
 			}
@@ -113,15 +113,19 @@ struct FZipLump : public FResourceLump
 
 	virtual FileReader *GetReader();
 	virtual int FillCache();
+	virtual bool ReadEncoded(const char *&data, long &length, TArray<char> &storage);
+	virtual void DecodeCache(const char *data, long length, char *dest);
 
 private:
 	void SetLumpAddress();
+	void Decompress(FileReader *reader, char *dest);
 	virtual int GetFileOffset() 
 	{ 
 		if (Method != METHOD_STORED) return -1;
 		if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
 		return Position; 
 	}
+	virtual bool IsStored() const { return Method == METHOD_STORED; }
 };
 
 
@@ -328,64 +332,106 @@ int FZipLump::FillCache()
 	if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
 	const char *buffer;
 
-	if (Method == METHOD_STORED && (buffer = Owner->Reader->GetBuffer()) != NULL)
+	if (Method == METHOD_STORED && (buffer = Owner->GetBufferRange(Position, LumpSize)) != NULL)
 	{
 		// This is an in-memory file so the cache can point directly to the file's data.
-		Cache = const_cast<char*>(buffer) + Position;
+		Cache = const_cast<char*>(buffer);
 		RefCount = -1;
 		return -1;
 	}
 
 	Owner->Reader->Seek(Position, SEEK_SET);
 	Cache = new char[LumpSize];
+	Decompress(Owner->Reader, Cache);
+	RefCount = 1;
+	return 1;
+}
+
+//==========================================================================
+//
+// Reads the lump's data from the start of its entry
+//
+//==========================================================================
+
+void FZipLump::Decompress(FileReader *reader, char *dest)
+{
 	switch (Method)
 	{
 		case METHOD_STORED:
 		{
-			Owner->Reader->Read(Cache, LumpSize);
+			reader->Read(dest, LumpSize);
 			break;
 		}
 
 		case METHOD_DEFLATE:
 		{
-			FileReaderZ frz(*Owner->Reader, true);
-			frz.Read(Cache, LumpSize);
+			FileReaderZ frz(*reader, true);
+			frz.Read(dest, LumpSize);
 			break;
 		}
 
 		case METHOD_BZIP2:
 		{
-			FileReaderBZ2 frz(*Owner->Reader);
-			frz.Read(Cache, LumpSize);
+			FileReaderBZ2 frz(*reader);
+			frz.Read(dest, LumpSize);
 			break;
 		}
 
 		case METHOD_LZMA:
 		{
-			FileReaderLZMA frz(*Owner->Reader, LumpSize, true);
-			frz.Read(Cache, LumpSize);
+			FileReaderLZMA frz(*reader, LumpSize, true);
+			frz.Read(dest, LumpSize);
 			break;
 		}
 
 		case METHOD_IMPLODE:
 		{
 			FZipExploder exploder;
-			exploder.Explode((unsigned char *)Cache, LumpSize, Owner->Reader, CompressedSize, GPFlags);
+			exploder.Explode((unsigned char *)dest, LumpSize, reader, CompressedSize, GPFlags);
 			break;
 		}
 
 		case METHOD_SHRINK:
 		{
-			ShrinkLoop((unsigned char *)Cache, LumpSize, Owner->Reader, CompressedSize);
+			ShrinkLoop((unsigned char *)dest, LumpSize, reader, CompressedSize);
 			break;
 		}
 
-		default:
+		default: // Rejected when the zip was opened
 			assert(0);
-			return 0;
+			break;
 	}
-	RefCount = 1;
-	return 1;
+}
+
+//==========================================================================
+//
+// Compressed entries are read here and decompressed by DecodeCache,
+// possibly on another thread.
+//
+//==========================================================================
+
+bool FZipLump::ReadEncoded(const char *&data, long &length, TArray<char> &storage)
+{
+	if (Method == METHOD_STORED || LumpSize == 0)
+		return false;
+
+	if (Flags & LUMPFZIP_NEEDFILESTART) SetLumpAddress();
+
+	length = CompressedSize;
+	if ((data = Owner->GetBufferRange(Position, CompressedSize)) != NULL)
+		return true;
+
+	storage.Resize(CompressedSize);
+	Owner->Reader->Seek(Position, SEEK_SET);
+	Owner->Reader->Read(&storage[0], CompressedSize);
+	data = &storage[0];
+	return true;
+}
+
+void FZipLump::DecodeCache(const char *data, long length, char *dest)
+{
+	MemoryReader reader(data, length);
+	Decompress(&reader, dest);
 }
 
 
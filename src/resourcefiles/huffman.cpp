@@ -0,0 +1,364 @@
+/*
+** huffman.cpp
+**
+**---------------------------------------------------------------------------
+** Copyright 2011 Braden Obrzut
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** ExpandTree was moved here from file_vgagraph.cpp and is Copyright 2011
+** Braden Obrzut. The table driven decoder and the benchmark are Copyright
+** 2026 The ECWolf Team.
+**
+*/
+
+#include <algorithm>
+#include <SDL.h>
+#include "huffman.h"
+#include "tarray.h"
+#include "zdoomsupport.h"
+
+void FHuffmanDecoder::Init(const Huffnode *nodes)
+{
+	Nodes = nodes;
+
+	for(unsigned int code = 0;code < TABLE_SIZE;++code)
+	{
+		Entry &entry = Table[code];
+		unsigned int node = HEAD_NODE;
+		entry.value = INVALID;
+		entry.bits = 0;
+
+		for(unsigned int bit = 0;bit < TABLE_BITS;++bit)
+		{
+			const WORD next = (code & (1<<bit)) ? nodes[node].bit1 : nodes[node].bit0;
+			if(next < 256)
+			{
+				entry.value = next;
+				entry.bits = bit+1;
+				break;
+			}
+
+			node = next - 256;
+			if(node >= NUM_NODES)
+				break;
+			if(bit == TABLE_BITS-1)
+			{
+				entry.value = next;
+				entry.bits = TABLE_BITS;
+			}
+		}
+	}
+}
+
+// The original decoder loads the next byte after finishing one and stops
+// if that was the last byte, throwing away any code it just finished. So
+// the last byte is never used and a code has to end before the last bit
+// of the one before it.
+byte *FHuffmanDecoder::Expand(const byte *source, DWORD length, byte *dest, DWORD destLength) const
+{
+	const byte *send = source + length;
+	const byte *end = dest + destLength;
+	const DWORD totalBits = 8*(MAX<DWORD>(length, 2) - 1);
+
+	DWORD bitbuf = 0;
+	unsigned int bitcount = 0;
+	DWORD pos = 0;
+	while(dest < end)
+	{
+		while(bitcount <= 24)
+		{
+			bitbuf |= DWORD(source < send ? *source++ : 0) << bitcount;
+			bitcount += 8;
+		}
+
+		const Entry &entry = Table[bitbuf & (TABLE_SIZE-1)];
+		if(entry.value < 256)
+		{
+			if(pos + entry.bits >= totalBits)
+				break;
+
+			*dest++ = (byte)entry.value;
+			bitbuf >>= entry.bits;
+			bitcount -= entry.bits;
+			pos += entry.bits;
+			continue;
+		}
+
+		if(entry.value == INVALID || pos + TABLE_BITS >= totalBits)
+			break;
+		bitbuf >>= TABLE_BITS;
+		bitcount -= TABLE_BITS;
+		pos += TABLE_BITS;
+
+		// Long code, finish it off a bit at a time. The code can be longer
+		// than what's left in the buffer.
+		const Huffnode *node = Nodes + (entry.value - 256);
+		for(;;)
+		{
+			if(bitcount == 0)
+			{
+				while(bitcount <= 24)
+				{
+					bitbuf |= DWORD(source < send ? *source++ : 0) << bitcount;
+					bitcount += 8;
+				}
+			}
+
+			const WORD next = (bitbuf & 1) ? node->bit1 : node->bit0;
+			bitbuf >>= 1;
+			--bitcount;
+			if(++pos >= totalBits)
+				return dest;
+
+			if(next < 256)
+			{
+				*dest++ = (byte)next;
+				break;
+			}
+			if(next - 256 >= NUM_NODES)
+				return dest;
+			node = Nodes + (next - 256);
+		}
+	}
+
+	return dest;
+}
+
+byte *FHuffmanDecoder::ExpandTree(const Huffnode *nodes, const byte *source, DWORD length, byte *dest, DWORD destLength)
+{
+	byte *end, *send;
+	const Huffnode *headptr, *huffptr;
+
+	headptr = nodes+HEAD_NODE;
+
+	end=dest+destLength;
+	send=const_cast<byte*>(source)+length;
+
+	byte val = *source++;
+	byte mask = 1;
+	word nodeval;
+	huffptr = headptr;
+	while(1)
+	{
+		if(!(val & mask))
+			nodeval = huffptr->bit0;
+		else
+			nodeval = huffptr->bit1;
+		if(mask==0x80)
+		{
+			val = *source++;
+			mask = 1;
+			if(source>=send) break;
+		}
+		else mask <<= 1;
+
+		if(nodeval<256)
+		{
+			*dest++ = (byte) nodeval;
+			huffptr = headptr;
+			if(dest>=end) break;
+		}
+		else
+		{
+			huffptr = nodes + (nodeval - 256);
+		}
+	}
+
+	return dest;
+}
+
+// Benchmark ---------------------------------------------------------------
+//
+// Builds a dictionary for some generated data and compresses it the way the
+// original tools would have. The picture case has a skewed distribution
+// like the original graphics. The deep case has a dictionary where the
+// rarest codes are over 40 bits long, more than the decoder's 32 bit
+// buffer holds, so the long code loop has to refill it mid code.
+
+static void BuildHuffman(const DWORD counts[256], Huffnode nodes[FHuffmanDecoder::NUM_NODES])
+{
+	DWORD weight[256];
+	WORD value[256];
+	unsigned int numActive = 256;
+	for(unsigned int i = 0;i < 256;++i)
+	{
+		weight[i] = counts[i] + 1;
+		value[i] = i;
+	}
+
+	// Join the two lightest until only the head is left.
+	for(unsigned int n = 0;n < FHuffmanDecoder::NUM_NODES;++n)
+	{
+		unsigned int a = 0, b = 1;
+		if(weight[b] < weight[a])
+			std::swap(a, b);
+		for(unsigned int i = 2;i < numActive;++i)
+		{
+			if(weight[i] < weight[a])
+			{
+				b = a;
+				a = i;
+			}
+			else if(weight[i] < weight[b])
+				b = i;
+		}
+
+		nodes[n].bit0 = value[a];
+		nodes[n].bit1 = value[b];
+
+		weight[a] += weight[b];
+		value[a] = 256+n;
+		--numActive;
+		weight[b] = weight[numActive];
+		value[b] = value[numActive];
+	}
+}
+
+static void GetCodes(const Huffnode *nodes, unsigned int node, QWORD code, unsigned int bits, QWORD codes[256], BYTE lengths[256])
+{
+	for(unsigned int b = 0;b < 2;++b)
+	{
+		const WORD next = b ? nodes[node].bit1 : nodes[node].bit0;
+		const QWORD nextCode = code | (QWORD(b)<<bits);
+		if(next < 256)
+		{
+			codes[next] = nextCode;
+			lengths[next] = bits+1;
+		}
+		else
+			GetCodes(nodes, next-256, nextCode, bits+1, codes, lengths);
+	}
+}
+
+static void BenchmarkCase(const char *name, const byte *raw, DWORD chunkSize, DWORD numChunks, const Huffnode nodes[FHuffmanDecoder::NUM_NODES])
+{
+	const int Passes = 10;
+
+	QWORD codes[256];
+	BYTE lengths[256];
+	GetCodes(nodes, FHuffmanDecoder::HEAD_NODE, 0, 0, codes, lengths);
+
+	unsigned int maxLength = 0;
+	for(unsigned int i = 0;i < 256;++i)
+		maxLength = MAX<unsigned int>(maxLength, lengths[i]);
+
+	// Each chunk is padded with two bytes since the decoders stop short.
+	TArray<byte> packed;
+	TArray<DWORD> chunkStart;
+	for(DWORD c = 0;c < numChunks;++c)
+	{
+		chunkStart.Push(packed.Size());
+		DWORD bitpos = 0;
+		for(DWORD i = 0;i < chunkSize;++i)
+		{
+			const byte ch = raw[c*chunkSize+i];
+			for(unsigned int b = 0;b < lengths[ch];++b, ++bitpos)
+			{
+				if((bitpos & 7) == 0)
+					packed.Push(0);
+				if(codes[ch] & (QWORD(1)<<b))
+					packed[packed.Size()-1] |= 1<<(bitpos & 7);
+			}
+		}
+		packed.Push(0);
+		packed.Push(0);
+	}
+	chunkStart.Push(packed.Size());
+
+	FHuffmanDecoder *decoder = new FHuffmanDecoder;
+	decoder->Init(nodes);
+	byte *out = new byte[chunkSize];
+
+	Printf("%s (%u chunks of %u bytes, %u compressed, longest code %u bits, %d passes)\n",
+		name, numChunks, chunkSize, chunkStart[numChunks], maxLength, Passes);
+	double basetime = 0;
+	for(int method = 0;method < 2;++method)
+	{
+		bool mismatch = false;
+		Uint32 start = SDL_GetTicks();
+		for(int p = 0;p < Passes;++p)
+		{
+			for(DWORD c = 0;c < numChunks;++c)
+			{
+				const byte *src = &packed[chunkStart[c]];
+				const DWORD len = chunkStart[c+1] - chunkStart[c];
+				byte *endptr = method == 0 ? FHuffmanDecoder::ExpandTree(nodes, src, len, out, chunkSize) :
+					decoder->Expand(src, len, out, chunkSize);
+				if(p == 0 && (endptr != out+chunkSize || memcmp(out, raw+c*chunkSize, chunkSize) != 0))
+					mismatch = true;
+			}
+		}
+		const double time = double(SDL_GetTicks() - start)/Passes;
+		if(method == 0)
+			basetime = time;
+
+		Printf("  %-6s %8.3f ms/pass  %5.2fx%s\n", method == 0 ? "tree" : "table", time,
+			time > 0 ? basetime/time : 0., mismatch ? "  MISMATCH" : "");
+	}
+
+	delete[] out;
+	delete decoder;
+}
+
+void VGA_BenchmarkHuffman()
+{
+	const DWORD ChunkSize = 64000, NumChunks = 32;
+
+	DWORD seed = 0x1234567;
+
+	byte *raw = new byte[ChunkSize*NumChunks];
+	DWORD counts[256] = {0};
+	for(DWORD i = 0;i < ChunkSize*NumChunks;++i)
+	{
+		// Mostly a few colors with some noise.
+		seed = seed * 1664525 + 1013904223;
+		raw[i] = (seed & 0x30000000) ? ((seed >> 24) & 15) + 16*((i/320)&7) : (byte)(seed >> 16);
+		++counts[raw[i]];
+	}
+
+	Huffnode nodes[FHuffmanDecoder::NUM_NODES];
+	BuildHuffman(counts, nodes);
+	BenchmarkCase("VGAGRAPH Huffman benchmark, picture", raw, ChunkSize, NumChunks, nodes);
+
+	// Fibonacci weights make each symbol a level deeper than the last. They
+	// start above the total of the unused symbols, which end up in a subtree
+	// at the bottom, and stop before the total overflows. The data still
+	// uses every symbol so the longest codes are exercised.
+	counts[0] = counts[1] = 256;
+	for(unsigned int i = 2;i < 256;++i)
+		counts[i] = i < 33 ? counts[i-1] + counts[i-2] : 0;
+	BuildHuffman(counts, nodes);
+	for(DWORD i = 0;i < ChunkSize*NumChunks;++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		raw[i] = (seed & 0x70000000) ? 22 + ((seed >> 16) & 7) : (byte)(seed >> 16);
+	}
+	BenchmarkCase("VGAGRAPH Huffman benchmark, deep", raw, ChunkSize, NumChunks, nodes);
+
+	delete[] raw;
+}
@@ -0,0 +1,93 @@
+/*
+** huffman.h
+**
+**---------------------------------------------------------------------------
+** Copyright 2011 Braden Obrzut
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Decoder for the Huffman compression used in VGAGRAPH files.
+**
+** Huffnode and the bit at a time decoder (ExpandTree) were moved here from
+** file_vgagraph.cpp and are Copyright 2011 Braden Obrzut. The table driven
+** decoder and the benchmark are Copyright 2026 The ECWolf Team.
+**
+*/
+
+#ifndef __HUFFMAN_H__
+#define __HUFFMAN_H__
+
+#include "wl_def.h"
+
+struct Huffnode
+{
+	public:
+		WORD	bit0, bit1;	// 0-255 is a character, > is a pointer to a node
+};
+
+// The dictionary has 255 nodes with the head always being node 254. Codes
+// are read starting from the low bit of each byte.
+//
+// Rather than walking the tree a bit at a time, the decoder looks up
+// TABLE_BITS bits at once which gives the character for every code that
+// short. Longer codes continue from the node the table leaves off at.
+class FHuffmanDecoder
+{
+	public:
+		enum { NUM_NODES = 255, HEAD_NODE = 254 };
+
+		void Init(const Huffnode *nodes);
+
+		// Returns the end of the decoded data. Stops at destLength or where
+		// the original decoder would have stopped in the source.
+		byte *Expand(const byte *source, DWORD length, byte *dest, DWORD destLength) const;
+
+		// The original bit at a time decoder.
+		static byte *ExpandTree(const Huffnode *nodes, const byte *source, DWORD length, byte *dest, DWORD destLength);
+
+	private:
+		enum
+		{
+			TABLE_BITS = 10,
+			TABLE_SIZE = 1<<TABLE_BITS,
+			INVALID = 0xFFFF
+		};
+
+		struct Entry
+		{
+			WORD	value; // Character, 256+node to continue from, or INVALID
+			BYTE	bits;
+		};
+
+		const Huffnode *Nodes;
+		Entry Table[TABLE_SIZE];
+};
+
+// Times both decoders on generated data and checks that they agree.
+void VGA_BenchmarkHuffman();
+
+#endif
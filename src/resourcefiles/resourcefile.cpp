@@ -336,6 +336,22 @@ FResourceFile::~FResourceFile()
 	delete Reader;
 }
 
+//==========================================================================
+//
+// Returns the in-memory data for a range of the file. NULL if the file
+// isn't in memory or the range runs past its end, as it can in a damaged
+// archive, in which case the data has to be read normally.
+//
+//==========================================================================
+
+const char *FResourceFile::GetBufferRange(long offset, long length) const
+{
+	const char *buffer = Reader->GetBuffer();
+	if (buffer == NULL || offset < 0 || length < 0 || offset > Reader->GetLength() - length)
+		return NULL;
+	return buffer + offset;
+}
+
 int STACK_ARGS lumpcmp(const void * a, const void * b)
 {
 	FResourceLump * rec1 = (FResourceLump *)a;
@@ -609,12 +625,12 @@ FileReader *FUncompressedLump::GetReader()
 
 int FUncompressedLump::FillCache()
 {
-	const char * buffer = Owner->Reader->GetBuffer();
+	const char * buffer = Owner->GetBufferRange(Position, LumpSize);
 
 	if (buffer != NULL)
 	{
 		// This is an in-memory file so the cache can point directly to the file's data.
-		Cache = const_cast<char*>(buffer) + Position;
+		Cache = const_cast<char*>(buffer);
 		RefCount = -1;
 		return -1;
 	}
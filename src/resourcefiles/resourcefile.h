@@ -51,6 +51,9 @@ struct FResourceLump
 	virtual FileReader *GetReader();
 	virtual FileReader *NewReader();
 	virtual int GetFileOffset() { return -1; }
+	// True if the data at GetFileOffset is the lump as is, not compressed
+	// or encrypted.
+	virtual bool IsStored() const { return false; }
 	virtual int GetIndexNum() const { return 0; }
 	virtual void DoFinishRemap() {} // For handling any changes that may happen after the WL6 remapper takes action
 	void LumpNameSetup(FString iname);
@@ -59,6 +62,14 @@ struct FResourceLump
 	void *CacheLump();
 	int ReleaseCache();
 
+	// For FWadCollection::CacheLumpBatch. Lumps which are slow to decode
+	// either hand out their encoded data so that DecodeCache can run on any
+	// thread, or give an order in which they should be filled one after
+	// another, away from the main thread, with the rest of their archive.
+	virtual bool ReadEncoded(const char *&data, long &length, TArray<char> &storage) { return false; }
+	virtual void DecodeCache(const char *data, long length, char *dest) {}
+	virtual int GetSerialOrder() const { return -1; }
+
 protected:
 	virtual int FillCache() = 0;
 
@@ -90,6 +101,7 @@ public:
 	static FResourceFile *OpenDirectory(const char *filename, bool quiet = false);
 	virtual ~FResourceFile();
 	FileReader *GetReader() const { return Reader; }
+	const char *GetBufferRange(long offset, long length) const;
 	DWORD LumpCount() const { return NumLumps; }
 	DWORD GetFirstLump() const { return FirstLump; }
 	void SetFirstLump(DWORD f) { FirstLump = f; }
@@ -106,6 +118,7 @@ struct FUncompressedLump : public FResourceLump
 	virtual FileReader *GetReader();
 	virtual int FillCache();
 	virtual int GetFileOffset() { return Position; }
+	virtual bool IsStored() const { return true; }
 
 };
 
@@ -32,97 +32,119 @@
 **
 */
 
+#include <algorithm>
+#include <SDL.h>
 #include "wolfmapcommon.h"
+#include "m_swap.h"
+#include "tarray.h"
+#include "w_wad.h"
+#include "zdoomsupport.h"
 
 // Only important thing to remember is that both
 // Compression methods work on WORDs rather than bytes.
+// The expanded WORDs are kept in their little endian byte order so nothing
+// needs to be swapped until the planes are actually used.
 
-void FMapLump::ExpandCarmack(const unsigned char* in, unsigned char* out)
+DWORD FMapLump::ExpandCarmack(const BYTE* in, DWORD inLength, WORD* out, DWORD outLength)
 {
-	const unsigned char* const end = out + ReadLittleShort((const BYTE*)in);
-	const unsigned char* const start = out;
-	in += 2;
+	const BYTE* const inEnd = in + inLength;
+	WORD* const start = out;
+	WORD* const end = out + outLength;
 
-	const unsigned char* copy;
-	BYTE length;
-	while(out < end)
+	while(out < end && in+2 <= inEnd)
 	{
-		length = *in++;
-		if(length == 0 && (*in == CARMACK_NEARTAG || *in == CARMACK_FARTAG))
+		const BYTE length = in[0];
+		const BYTE tag = in[1];
+		if(tag != CARMACK_NEARTAG && tag != CARMACK_FARTAG)
 		{
-			*out++ = in[1];
-			*out++ = in[0];
+			memcpy(out++, in, 2);
 			in += 2;
 			continue;
 		}
-		else if(*in == CARMACK_NEARTAG)
+
+		if(in+3 > inEnd)
+			break;
+		if(length == 0)
 		{
-			copy = out-(in[1]*2);
-			in += 2;
+			// Literal word which happens to have a tag as its high byte.
+			const BYTE word[2] = { in[2], tag };
+			memcpy(out++, word, 2);
+			in += 3;
+			continue;
 		}
-		else if(*in == CARMACK_FARTAG)
+
+		const WORD* copy;
+		if(tag == CARMACK_NEARTAG)
 		{
-			copy = start+(ReadLittleShort((const BYTE*)(in+1))*2);
+			copy = out-in[2];
 			in += 3;
 		}
 		else
 		{
-			*out++ = length;
-			*out++ = *in++;
-			continue;
+			if(in+4 > inEnd)
+				break;
+			copy = start+ReadLittleShort(in+2);
+			in += 4;
 		}
-		if(out+(length*2) > end)
+		if(copy < start || copy >= out || out+length > end)
 			break;
-		while(length-- > 0)
+
+		// Overlapping copies repeat the pattern so they must go word by word.
+		if(copy+length <= out)
 		{
-			*out++ = *copy++;
-			*out++ = *copy++;
+			memcpy(out, copy, length*2);
+			out += length;
+		}
+		else
+		{
+			for(WORD* const stop = out+length;out < stop;)
+				*out++ = *copy++;
 		}
 	}
+
+	return DWORD(out-start);
 }
 
-void FMapLump::ExpandRLEW(const unsigned char* in, unsigned char* out, const DWORD length, const WORD rlewTag)
+DWORD FMapLump::ExpandRLEW(const BYTE* in, DWORD inLength, WORD* out, DWORD outLength, const WORD rlewTag)
 {
-	const unsigned char* const end = out+length;
+	const BYTE* const inEnd = in + (inLength&~1);
+	WORD* const start = out;
+	WORD* const end = out + outLength;
 
-	while(out < end)
+	while(out < end && in < inEnd)
 	{
-		if(ReadLittleShort((const BYTE*)in) != rlewTag)
+		if(ReadLittleShort(in) != rlewTag)
 		{
-			*out++ = *in++;
-			*out++ = *in++;
+			memcpy(out++, in, 2);
+			in += 2;
 		}
 		else
 		{
-			WORD count = ReadLittleShort((const BYTE*)(in+2));
-			WORD input = ReadLittleShort((const BYTE*)(in+4));
+			if(in+6 > inEnd)
+				break;
+
+			WORD fill;
+			memcpy(&fill, in+4, 2);
+			const DWORD count = MIN<DWORD>(ReadLittleShort(in+2), DWORD(end-out));
+			std::fill(out, out+count, fill);
+			out += count;
 			in += 6;
-			while(count-- > 0)
-			{
-				WriteLittleShort((BYTE*)out, input);
-				out += 2;
-			}
 		}
 	}
+
+	return DWORD(out-start);
 }
 
-int FMapLump::FillCache()
+void FMapLump::ExpandPlanes(WORD* output)
 {
-	if(LumpSize == 0)
-		return 1;
+	const unsigned int PlaneSize = Header.Width*Header.Height;
 
-	unsigned int PlaneSize = Header.Width*Header.Height*2;
+	// When the map file is already in memory decode straight out of it,
+	// otherwise each plane is read into one buffer shared by all of them.
+	FileReader* const reader = Owner->Reader;
+	TArray<BYTE> input;
+	TArray<WORD> carmackOut;
 
-	Cache = new char[LumpSize];
-	strcpy(Cache, "WDC3.1");
-	WriteLittleShort((BYTE*)&Cache[10], rtlMap ? 4 : 3);
-	WriteLittleShort((BYTE*)&Cache[12], 16);
-	WriteLittleShort((BYTE*)&Cache[HEADERSIZE-4], Header.Width);
-	WriteLittleShort((BYTE*)&Cache[HEADERSIZE-2], Header.Height);
-	memcpy(&Cache[14], Header.Name, 16);
-
-	// Read map data and expand it
-	unsigned char* output = reinterpret_cast<unsigned char*>(Cache+HEADERSIZE);
 	for(unsigned int i = 0;i < PLANES;++i)
 	{
 		// ChaosEdit HACK: Likely in order to save a few bytes ChaosEdit sets
@@ -130,50 +152,133 @@ int FMapLump::FillCache()
 		// doesn't use the data). If we see this we need to zero fill the plane.
 		if(i == 2 && Header.PlaneOffset[1] == Header.PlaneOffset[2] && !rtlMap)
 		{
-			memset(output, 0, PlaneSize);
+			memset(output, 0, PlaneSize*2);
 			output += PlaneSize;
 			continue;
 		}
 
-		if(Header.PlaneLength[i])
+		DWORD length = Header.PlaneLength[i];
+		DWORD expanded = 0;
+		if(length)
 		{
-			unsigned char* input = new unsigned char[Header.PlaneLength[i]];
-			Owner->Reader->Seek(Header.PlaneOffset[i], SEEK_SET);
-			Owner->Reader->Read(input, Header.PlaneLength[i]);
-
-			if(carmackCompressed)
+			const BYTE* data = reinterpret_cast<const BYTE*>(Owner->GetBufferRange(Header.PlaneOffset[i], length));
+			if(data == NULL)
 			{
-				unsigned char* tempOut = new unsigned char[ReadLittleShort((BYTE*)input)];
-				ExpandCarmack(input, tempOut);
-				ExpandRLEW(tempOut+2, output, ReadLittleShort((const BYTE*)tempOut), rlewTag);
-				delete[] tempOut;
+				input.Resize(length);
+				reader->Seek(Header.PlaneOffset[i], SEEK_SET);
+				length = MAX<long>(reader->Read(&input[0], length), 0);
+				data = &input[0];
 			}
-			else
+
+			if(carmackCompressed)
 			{
-				if(rtlMap)
-					ExpandRLEW(input, output, PlaneSize, rlewTag);
-				else
-					ExpandRLEW(input+2, output, ReadLittleShort((const BYTE*)input), rlewTag);
+				if(length >= 2)
+				{
+					const DWORD carmackLength = ReadLittleShort(data)/2;
+					carmackOut.Resize(MAX<DWORD>(carmackLength, 1));
+					const DWORD got = ExpandCarmack(data+2, length-2, &carmackOut[0], carmackLength);
+					if(got < carmackLength)
+						memset(&carmackOut[got], 0, (carmackLength-got)*2);
+					if(carmackLength >= 1)
+					{
+						expanded = ExpandRLEW((const BYTE*)&carmackOut[1], (carmackLength-1)*2, output,
+							MIN<DWORD>(LittleShort(carmackOut[0])/2, PlaneSize), rlewTag);
+					}
+				}
 			}
-
-			delete[] input;
+			else if(rtlMap)
+				expanded = ExpandRLEW(data, length, output, PlaneSize, rlewTag);
+			else if(length >= 2)
+				expanded = ExpandRLEW(data+2, length-2, output, MIN<DWORD>(ReadLittleShort(data)/2, PlaneSize), rlewTag);
 		}
-		else
-			memset(output, 0, PlaneSize);
+
+		// Truncated or missing planes are zero filled past what we got.
+		if(expanded < PlaneSize)
+			memset(output+expanded, 0, (PlaneSize-expanded)*2);
 		output += PlaneSize;
 
 		// RTL maps don't have a floor/ceiling texture plane so insert one
 		// We do this after the things plane has been read
 		if(rtlMap && i == 1)
 		{
-			const WORD floorTex = ReadLittleShort((const BYTE*)(Cache+HEADERSIZE))-0xB4;
-			const WORD ceilingTex = ReadLittleShort((const BYTE*)(Cache+HEADERSIZE+2))-0xC6;
-			const WORD fill = (floorTex&0xFF)|((ceilingTex&0xFF)<<8);
-			WORD *out = reinterpret_cast<WORD*>(output);
-			for(unsigned int j = 0;j < PlaneSize/2;++j)
-				*out++ = fill;
+			const BYTE* const tiles = reinterpret_cast<const BYTE*>(output-PlaneSize*2);
+			const WORD floorTex = ReadLittleShort(tiles)-0xB4;
+			const WORD ceilingTex = ReadLittleShort(tiles+2)-0xC6;
+			const WORD fill = LittleShort((WORD)((floorTex&0xFF)|((ceilingTex&0xFF)<<8)));
+			std::fill(output, output+PlaneSize, fill);
 			output += PlaneSize;
 		}
 	}
+}
+
+int FMapLump::FillCache()
+{
+	if(LumpSize == 0)
+		return 1;
+
+	Cache = new char[LumpSize];
+	memset(Cache, 0, HEADERSIZE);
+	memcpy(Cache, "WDC3.1", 6);
+	WriteLittleLong((BYTE*)&Cache[6], 1);
+	WriteLittleShort((BYTE*)&Cache[10], rtlMap ? 4 : 3);
+	WriteLittleShort((BYTE*)&Cache[12], HEADERSIZE-18);
+	WriteLittleShort((BYTE*)&Cache[HEADERSIZE-4], Header.Width);
+	WriteLittleShort((BYTE*)&Cache[HEADERSIZE-2], Header.Height);
+	memcpy(&Cache[14], Header.Name, 16);
+
+	ExpandPlanes(reinterpret_cast<WORD*>(Cache+HEADERSIZE));
+	RefCount = 1;
 	return 1;
 }
+
+//==========================================================================
+//
+// MAP_BenchmarkPlanes
+//
+// Times expanding every binary map in the loaded data the way the level
+// loader gets at them.
+//
+//==========================================================================
+
+void MAP_BenchmarkPlanes()
+{
+	static const int Passes = 20;
+
+	TArray<int> maps;
+	for(int i = 0;i < Wads.GetNumLumps();++i)
+	{
+		const char* name = Wads.GetLumpFullName(i);
+		if(name != NULL && stricmp(name, "PLANES") == 0)
+			maps.Push(i);
+	}
+
+	Printf("Map plane benchmark (%u maps, %d passes)\n", maps.Size(), Passes);
+	if(maps.Size() == 0)
+		return;
+
+	double bytes = 0;
+	WORD checksum = 0;
+	Uint32 start = SDL_GetTicks();
+	for(int p = 0;p < Passes;++p)
+	{
+		for(unsigned int m = 0;m < maps.Size();++m)
+		{
+			FWadLump *lump = Wads.ReopenLumpNum(maps[m]);
+			const char* data = lump->GetBuffer();
+			if(data != NULL && lump->GetLength() > HEADERSIZE)
+			{
+				// Touch the planes so the work can't be skipped.
+				const long length = lump->GetLength();
+				for(long i = HEADERSIZE;i < length;i += 64)
+					checksum += (BYTE)data[i];
+				if(p == 0)
+					bytes += length;
+			}
+			delete lump;
+		}
+	}
+	const double time = double(SDL_GetTicks() - start)/Passes;
+
+	Printf("  expand %8.3f ms/pass  %6.3f ms/map  %7.1f MB/s  (%04X)\n", time, time/maps.Size(),
+		time > 0 ? bytes/(time*1000.) : 0., checksum);
+}
@@ -40,18 +40,24 @@
 
 #define RTLCONVERTEDPLANES 4
 #define PLANES 3
-#define HEADERSIZE 34
+// The name field is padded so that the planes start 16 byte aligned.
+#define HEADERSIZE 48
 #define CARMACK_NEARTAG	static_cast<unsigned char>(0xA7)
 #define CARMACK_FARTAG	static_cast<unsigned char>(0xA8)
 
 struct FMapLump : public FResourceLump
 {
 	protected:
-		void ExpandCarmack(const unsigned char* in, unsigned char* out);
-		void ExpandRLEW(const unsigned char* in, unsigned char* out, const DWORD length, const WORD rlewTag);
+		// Both return the number of words written to out.
+		static DWORD ExpandCarmack(const BYTE* in, DWORD inLength, WORD* out, DWORD outLength);
+		static DWORD ExpandRLEW(const BYTE* in, DWORD inLength, WORD* out, DWORD outLength, const WORD rlewTag);
 
 		int FillCache();
 	public:
+		// Expands every plane straight into out, which must be able to hold
+		// LumpSize-HEADERSIZE bytes. Words are stored little endian.
+		void ExpandPlanes(WORD* out);
+
 		struct
 		{
 			DWORD	PlaneOffset[PLANES];
@@ -75,4 +81,6 @@ struct FMapLump : public FResourceLump
 		}
 };
 
+void MAP_BenchmarkPlanes();
+
 #endif
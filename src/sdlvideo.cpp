@@ -225,11 +225,19 @@ void I_ShutdownGraphics ()
 	SDL_QuitSubSystem (SDL_INIT_VIDEO);
 }
 
+static IVideo *CreateHeadlessVideo ();
+
 void I_InitGraphics ()
 {
 	if(Video)
 		return;
 
+	if (param_headless)
+	{
+		Video = CreateHeadlessVideo ();
+		return;
+	}
+
 	if (SDL_InitSubSystem (SDL_INIT_VIDEO) < 0)
 	{
 		I_FatalError ("Could not initialize SDL video:\n%s\n", SDL_GetError());
@@ -308,6 +316,35 @@ private:
 	bool NeedGammaUpdate;
 	bool NotPaletted;
 
+#if SDL_VERSION_ATLEAST(2,0,0)
+	// When vid_asyncpresent is set, a second thread converts the bottom half
+	// of each frame while the game thread converts the top half. SDL only
+	// allows the renderer to be used from the thread which created it, so
+	// all SDL video calls stay on the game thread. The convert thread only
+	// touches GPfx between StartConvert and FinishConvert, during which the
+	// game thread leaves the palette and format alone.
+	SDL_Thread *ConvertThread;
+	SDL_mutex *ConvertMutex;
+	SDL_cond *ConvertCond;
+	const BYTE *ConvertSrc;
+	int ConvertSrcPitch;
+	BYTE *ConvertDest;
+	int ConvertDestPitch;
+	int ConvertRows;
+	bool ConvertPending;
+	bool ConvertQuit;
+
+	static int ConvertThreadFunc (void *data);
+	void ConvertLoop ();
+	void StartConvert (const BYTE *src, int srcpitch, BYTE *dest, int destpitch, int rows);
+	void FinishConvert ();
+	void StartConvertThread ();
+	void StopConvertThread ();
+	void CreateRenderer ();
+	void DestroyRenderer ();
+	bool PresentBuffer (const BYTE *buffer, int pitch);
+#endif
+
 	void UpdateColors ();
 	void ResetSDLRenderer ();
 
@@ -315,6 +352,48 @@ private:
 };
 IMPLEMENT_INTERNAL_CLASS(SDLFB)
 
+// Used by --timedemo. Rendering goes into system memory and is never shown
+// so the engine can run without a display.
+class HeadlessVideo : public SDLVideo
+{
+public:
+	HeadlessVideo () : SDLVideo (0) {}
+
+	EDisplayType GetDisplayType () { return DISPLAY_WindowOnly; }
+	DFrameBuffer *CreateFrameBuffer (int width, int height, bool fs, DFrameBuffer *old);
+};
+
+class HeadlessFB : public DFrameBuffer
+{
+	DECLARE_CLASS(HeadlessFB, DFrameBuffer)
+public:
+	HeadlessFB (int width, int height);
+
+	bool Lock (bool buffered);
+	void Unlock ();
+	void Update ();
+	PalEntry *GetPalette ();
+	void GetFlashedPalette (PalEntry pal[256]);
+	void UpdatePalette () {}
+	bool SetGamma (float gamma) { return true; }
+	bool SetFlash (PalEntry rgb, int amount);
+	void GetFlash (PalEntry &rgb, int &amount);
+	int GetPageCount () { return 1; }
+	bool IsFullscreen () { return false; }
+
+	void PaletteChanged () { }
+	int QueryNewPalette () { return 0; }
+	bool Is8BitMode() { return true; }
+
+private:
+	PalEntry SourcePalette[256];
+	PalEntry Flash;
+	int FlashAmount;
+
+	HeadlessFB () {}
+};
+IMPLEMENT_INTERNAL_CLASS(HeadlessFB)
+
 struct MiniModeInfo
 {
 	WORD Width, Height;
@@ -652,6 +731,10 @@ SDLFB::SDLFB (int width, int height, bool fullscreen)
 	FlashAmount = 0;
 
 #if SDL_VERSION_ATLEAST(2,0,0)
+	ConvertThread = NULL;
+	ConvertMutex = NULL;
+	ConvertCond = NULL;
+
 	if (oldwin)
 	{
 		// In some cases (Mac OS X fullscreen) SDL2 doesn't like having multiple windows which
@@ -682,6 +765,9 @@ SDLFB::SDLFB (int width, int height, bool fullscreen)
 	Texture = NULL;
 	ResetSDLRenderer ();
 
+	if (vid_asyncpresent)
+		StartConvertThread ();
+
 	for (i = 0; i < 256; i++)
 	{
 		GammaTable[0][i] = GammaTable[1][i] = GammaTable[2][i] = i;
@@ -730,12 +816,8 @@ SDLFB::SDLFB (int width, int height, bool fullscreen)
 SDLFB::~SDLFB ()
 {
 #if SDL_VERSION_ATLEAST(2,0,0)
-	if (Renderer)
-	{
-		if (Texture)
-			SDL_DestroyTexture (Texture);
-		SDL_DestroyRenderer (Renderer);
-	}
+	StopConvertThread ();
+	DestroyRenderer ();
 
 	if(Screen)
 	{
@@ -809,61 +891,8 @@ void SDLFB::Update ()
 	//BlitCycles.Clock();
 
 #if SDL_VERSION_ATLEAST(2,0,0)
-	void *pixels;
-	int pitch;
-	if (UsingRenderer)
-	{
-		if (SDL_LockTexture (Texture, NULL, &pixels, &pitch))
-			return;
-	}
-	else
-	{
-		if (SDL_LockSurface (Surface))
-			return;
-
-		pixels = Surface->pixels;
-		pitch = Surface->pitch;
-	}
-
-	if (NotPaletted)
-	{
-		GPfx.Convert (MemBuffer, Pitch,
-			pixels, pitch, Width, Height,
-			FRACUNIT, FRACUNIT, 0, 0);
-	}
-	else
-	{
-		if (pitch == Pitch)
-		{
-			memcpy (pixels, MemBuffer, Width*Height);
-		}
-		else
-		{
-			for (int y = 0; y < Height; ++y)
-			{
-				memcpy ((BYTE *)pixels+y*pitch, MemBuffer+y*Pitch, Width);
-			}
-		}
-	}
-
-	if (UsingRenderer)
-	{
-		SDL_UnlockTexture (Texture);
-
-		//SDLFlipCycles.Clock();
-		SDL_RenderClear(Renderer);
-		SDL_RenderCopy(Renderer, Texture, NULL, NULL);
-		SDL_RenderPresent(Renderer);
-		//SDLFlipCycles.Unclock();
-	}
-	else
-	{
-		SDL_UnlockSurface (Surface);
-
-		//SDLFlipCycles.Clock();
-		SDL_UpdateWindowSurface (Screen);
-		//SDLFlipCycles.Unclock();
-	}
+	if (!PresentBuffer (MemBuffer, Pitch))
+		return;
 #else
 	if (SDL_LockSurface (Screen) == -1)
 		return;
@@ -923,6 +952,163 @@ void SDLFB::Update ()
 	}
 }
 
+#if SDL_VERSION_ATLEAST(2,0,0)
+bool SDLFB::PresentBuffer (const BYTE *buffer, int bufferpitch)
+{
+	void *pixels;
+	int pitch;
+	if (UsingRenderer)
+	{
+		if (SDL_LockTexture (Texture, NULL, &pixels, &pitch))
+			return false;
+	}
+	else
+	{
+		if (SDL_LockSurface (Surface))
+			return false;
+
+		pixels = Surface->pixels;
+		pitch = Surface->pitch;
+	}
+
+	if (NotPaletted)
+	{
+		int rows = 0;
+		if (ConvertThread != NULL)
+		{
+			rows = Height/2;
+			StartConvert (buffer+(Height-rows)*bufferpitch, bufferpitch,
+				(BYTE *)pixels+(Height-rows)*pitch, pitch, rows);
+		}
+
+		GPfx.Convert (const_cast<BYTE *>(buffer), bufferpitch,
+			pixels, pitch, Width, Height-rows,
+			FRACUNIT, FRACUNIT, 0, 0);
+
+		if (rows)
+			FinishConvert ();
+	}
+	else
+	{
+		if (pitch == bufferpitch)
+		{
+			memcpy (pixels, buffer, Width*Height);
+		}
+		else
+		{
+			for (int y = 0; y < Height; ++y)
+			{
+				memcpy ((BYTE *)pixels+y*pitch, buffer+y*bufferpitch, Width);
+			}
+		}
+	}
+
+	if (UsingRenderer)
+	{
+		SDL_UnlockTexture (Texture);
+
+		//SDLFlipCycles.Clock();
+		SDL_RenderClear(Renderer);
+		SDL_RenderCopy(Renderer, Texture, NULL, NULL);
+		SDL_RenderPresent(Renderer);
+		//SDLFlipCycles.Unclock();
+	}
+	else
+	{
+		SDL_UnlockSurface (Surface);
+
+		//SDLFlipCycles.Clock();
+		SDL_UpdateWindowSurface (Screen);
+		//SDLFlipCycles.Unclock();
+	}
+	return true;
+}
+
+void SDLFB::StartConvert (const BYTE *src, int srcpitch, BYTE *dest, int destpitch, int rows)
+{
+	SDL_LockMutex (ConvertMutex);
+	ConvertSrc = src;
+	ConvertSrcPitch = srcpitch;
+	ConvertDest = dest;
+	ConvertDestPitch = destpitch;
+	ConvertRows = rows;
+	ConvertPending = true;
+	SDL_CondBroadcast (ConvertCond);
+	SDL_UnlockMutex (ConvertMutex);
+}
+
+void SDLFB::FinishConvert ()
+{
+	SDL_LockMutex (ConvertMutex);
+	while (ConvertPending)
+		SDL_CondWait (ConvertCond, ConvertMutex);
+	SDL_UnlockMutex (ConvertMutex);
+}
+
+int SDLFB::ConvertThreadFunc (void *data)
+{
+	static_cast<SDLFB *>(data)->ConvertLoop ();
+	return 0;
+}
+
+void SDLFB::ConvertLoop ()
+{
+	SDL_LockMutex (ConvertMutex);
+	for (;;)
+	{
+		while (!ConvertPending && !ConvertQuit)
+			SDL_CondWait (ConvertCond, ConvertMutex);
+		if (ConvertQuit)
+			break;
+		SDL_UnlockMutex (ConvertMutex);
+
+		GPfx.Convert (const_cast<BYTE *>(ConvertSrc), ConvertSrcPitch,
+			ConvertDest, ConvertDestPitch, Width, ConvertRows,
+			FRACUNIT, FRACUNIT, 0, 0);
+
+		SDL_LockMutex (ConvertMutex);
+		ConvertPending = false;
+		SDL_CondBroadcast (ConvertCond);
+	}
+	SDL_UnlockMutex (ConvertMutex);
+}
+
+void SDLFB::StartConvertThread ()
+{
+	ConvertMutex = SDL_CreateMutex ();
+	ConvertCond = SDL_CreateCond ();
+	ConvertPending = false;
+	ConvertQuit = false;
+	if (ConvertMutex != NULL && ConvertCond != NULL)
+		ConvertThread = SDL_CreateThread (ConvertThreadFunc, "Convert", this);
+
+	// Without the thread the whole frame is simply converted on the game thread
+	if (ConvertThread == NULL)
+		StopConvertThread ();
+}
+
+void SDLFB::StopConvertThread ()
+{
+	if (ConvertThread != NULL)
+	{
+		SDL_LockMutex (ConvertMutex);
+		ConvertQuit = true;
+		SDL_CondBroadcast (ConvertCond);
+		SDL_UnlockMutex (ConvertMutex);
+
+		SDL_WaitThread (ConvertThread, NULL);
+		ConvertThread = NULL;
+	}
+
+	if (ConvertCond)
+		SDL_DestroyCond (ConvertCond);
+	if (ConvertMutex)
+		SDL_DestroyMutex (ConvertMutex);
+	ConvertCond = NULL;
+	ConvertMutex = NULL;
+}
+#endif
+
 void SDLFB::UpdateColors ()
 {
 	if (NotPaletted)
@@ -1037,14 +1223,28 @@ bool SDLFB::IsFullscreen ()
 void SDLFB::ResetSDLRenderer ()
 {
 #if SDL_VERSION_ATLEAST(2,0,0)
+	DestroyRenderer ();
+
+	UsingRenderer = !vid_forcesurface;
+	CreateRenderer ();
+#endif
+}
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+void SDLFB::DestroyRenderer ()
+{
 	if (Renderer)
 	{
 		if (Texture)
 			SDL_DestroyTexture (Texture);
 		SDL_DestroyRenderer (Renderer);
 	}
+	Renderer = NULL;
+	Texture = NULL;
+}
 
-	UsingRenderer = !vid_forcesurface;
+void SDLFB::CreateRenderer ()
+{
 	if (UsingRenderer)
 	{
 		Renderer = SDL_CreateRenderer (Screen, -1,SDL_RENDERER_ACCELERATED|SDL_RENDERER_TARGETTEXTURE|
@@ -1099,8 +1299,8 @@ void SDLFB::ResetSDLRenderer ()
 		ScaleWithAspect (w, h, Width, Height);
 		SDL_RenderSetLogicalSize (Renderer, w, h);
 	}
-#endif
 }
+#endif
 
 void SDLFB::SetVSync (bool vsync)
 {
@@ -1146,6 +1346,82 @@ void SDLFB::ScaleCoordsFromWindow(SWORD &x, SWORD &y)
 #endif
 }
 
+// Headless implementation -------------------------------------------------
+
+static IVideo *CreateHeadlessVideo ()
+{
+	return new HeadlessVideo;
+}
+
+DFrameBuffer *HeadlessVideo::CreateFrameBuffer (int width, int height, bool fs, DFrameBuffer *old)
+{
+	if (old != NULL)
+	{
+		if (old->GetWidth() == width && old->GetHeight() == height)
+			return old;
+
+		old->ObjectFlags |= OF_YesReallyDelete;
+		if (screen == old) screen = NULL;
+		delete old;
+	}
+
+	HeadlessFB *fb = new HeadlessFB (width, height);
+	if (!fb->IsValid ())
+		I_FatalError ("Could not create new screen (%d x %d)", width, height);
+	return fb;
+}
+
+HeadlessFB::HeadlessFB (int width, int height)
+	: DFrameBuffer (width, height)
+{
+	FlashAmount = 0;
+	memcpy (SourcePalette, GPalette.BaseColors, sizeof(PalEntry)*256);
+}
+
+bool HeadlessFB::Lock (bool buffered)
+{
+	return DSimpleCanvas::Lock ();
+}
+
+void HeadlessFB::Unlock ()
+{
+	DSimpleCanvas::Unlock ();
+}
+
+void HeadlessFB::Update ()
+{
+	// Nothing to present, just release the lock the same way SDLFB does.
+	if (LockCount > 0)
+		DSimpleCanvas::Unlock ();
+}
+
+PalEntry *HeadlessFB::GetPalette ()
+{
+	return SourcePalette;
+}
+
+bool HeadlessFB::SetFlash (PalEntry rgb, int amount)
+{
+	Flash = rgb;
+	FlashAmount = amount;
+	return true;
+}
+
+void HeadlessFB::GetFlash (PalEntry &rgb, int &amount)
+{
+	rgb = Flash;
+	amount = FlashAmount;
+}
+
+void HeadlessFB::GetFlashedPalette (PalEntry pal[256])
+{
+	memcpy (pal, SourcePalette, 256*sizeof(PalEntry));
+	if (FlashAmount)
+	{
+		DoBlending (pal, pal, 256, Flash.r, Flash.g, Flash.b, FlashAmount);
+	}
+}
+
 #if 0
 ADD_STAT (blit)
 {
@@ -215,6 +215,17 @@ void SoundInformation::Init()
 {
 	printf("S_Init: Reading SNDINFO defintions.\n");
 
+	// Sounds are loaded as the definitions are parsed, so get any which are
+	// compressed decoded together first.
+	TArray<int> soundLumps;
+	for(int i = 0;i < Wads.GetNumLumps();++i)
+	{
+		if(Wads.GetLumpNamespace(i) == ns_sounds)
+			soundLumps.Push(i);
+	}
+	FLumpBatch batch;
+	Wads.CacheLumpBatch(soundLumps, batch);
+
 	int lastLump = 0;
 	int lump = 0;
 	while((lump = Wads.FindLump("SNDINFO", &lastLump)) != -1)
@@ -0,0 +1,301 @@
+/*
+** stats.cpp
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Timer plumbing for cycle_t and the sliding window behind the profiling
+** overlay and CSV dump.
+**
+*/
+
+#include <SDL.h>
+#include <stdio.h>
+
+#include "wl_def.h"
+#include "id_vh.h"
+#include "v_font.h"
+#include "v_palette.h"
+#include "v_video.h"
+#include "wl_draw.h"
+#include "wl_game.h"
+#include "stats.h"
+#include "zstring.h"
+
+double PerfToSec = 0, PerfToMillisec = 0;
+
+void I_InitClock()
+{
+	if(PerfToSec != 0)
+		return;
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+	PerfToSec = 1.0/SDL_GetPerformanceFrequency();
+#else
+	PerfToSec = 1.0/1000;
+#endif
+	PerfToMillisec = PerfToSec*1000;
+}
+
+QWORD I_ClockNow()
+{
+#if SDL_VERSION_ATLEAST(2,0,0)
+	return SDL_GetPerformanceCounter();
+#else
+	return SDL_GetTicks();
+#endif
+}
+
+FStat* FStat::FirstStat = NULL;
+
+FStat::FStat(const char* name) : Name(name), Next(FirstStat)
+{
+	FirstStat = this;
+}
+
+FStat::~FStat()
+{
+	for(FStat** stat = &FirstStat;*stat;stat = &(*stat)->Next)
+	{
+		if(*stat == this)
+		{
+			*stat = Next;
+			break;
+		}
+	}
+}
+
+//==========================================================================
+
+namespace Profiler {
+
+bool Active = false;
+bool ShowOverlay = false;
+cycle_t Cycles[NUM_PROFILE_STAGES];
+FProfileScope* CurrentScope = NULL;
+
+static const char* const StageNames[NUM_PROFILE_STAGES+1] = {
+	"Walls",
+	"Floors",
+	"Skies",
+	"Sprites",
+	"Weapon",
+	"StatusBar",
+	"Thinkers",
+	"GC",
+	"Present",
+	"Frame"
+};
+
+// The last column of each sample is the wall time between EndFrame calls.
+static float Samples[WINDOW_SIZE][NUM_PROFILE_STAGES+1];
+static unsigned int SampleHead = 0, NumSamples = 0;
+static unsigned int FrameCount = 0;
+static QWORD LastFrame = 0;
+static FILE* CSVFile = NULL;
+
+static void UpdateActive()
+{
+	bool wasActive = Active;
+	Active = ShowOverlay || CSVFile != NULL;
+
+	if(Active && !wasActive)
+	{
+		I_InitClock();
+		Resync();
+		SampleHead = NumSamples = 0;
+	}
+}
+
+static void CloseCSV()
+{
+	if(CSVFile)
+	{
+		fclose(CSVFile);
+		CSVFile = NULL;
+	}
+}
+
+bool OpenCSV(const char* filename)
+{
+	CloseCSV();
+
+	CSVFile = fopen(filename, "w");
+	if(!CSVFile)
+		return false;
+
+	static bool registered = false;
+	if(!registered)
+	{
+		atexit(CloseCSV);
+		registered = true;
+	}
+
+	fputs("frame,tic", CSVFile);
+	for(unsigned int i = 0;i <= NUM_PROFILE_STAGES;++i)
+		fprintf(CSVFile, ",%s", StageNames[i]);
+	fputc('\n', CSVFile);
+
+	UpdateActive();
+	return true;
+}
+
+void SetOverlay(bool show)
+{
+	ShowOverlay = show;
+	UpdateActive();
+}
+
+// Discards anything accumulated since the last frame, used when entering the
+// play loop so time spent in menus doesn't show up as a frame spike.
+void Resync()
+{
+	for(unsigned int i = 0;i < NUM_PROFILE_STAGES;++i)
+		Cycles[i].Reset();
+	LastFrame = 0;
+}
+
+void EndFrame()
+{
+	if(!Active)
+		return;
+
+	const QWORD now = I_ClockNow();
+	if(LastFrame == 0)
+	{
+		// No reference point for the frame time so just start counting.
+		Resync();
+		LastFrame = now;
+		return;
+	}
+
+	float* sample = Samples[SampleHead];
+	for(unsigned int i = 0;i < NUM_PROFILE_STAGES;++i)
+	{
+		sample[i] = static_cast<float>(Cycles[i].TimeMS());
+		Cycles[i].Reset();
+	}
+	sample[NUM_PROFILE_STAGES] = static_cast<float>((now - LastFrame)*PerfToMillisec);
+	LastFrame = now;
+
+	SampleHead = (SampleHead + 1) % WINDOW_SIZE;
+	if(NumSamples < WINDOW_SIZE)
+		++NumSamples;
+
+	if(CSVFile)
+	{
+		fprintf(CSVFile, "%u,%d", FrameCount, gamestate.TimeCount);
+		for(unsigned int i = 0;i <= NUM_PROFILE_STAGES;++i)
+			fprintf(CSVFile, ",%.3f", sample[i]);
+		fputc('\n', CSVFile);
+	}
+	++FrameCount;
+}
+
+// Draws a table of min/avg/max in milliseconds below the FPS counter.
+void DrawOverlay()
+{
+	if(!ShowOverlay || NumSamples == 0)
+		return;
+
+	static const word ValueColumns[3] = { 88, 124, 160 };
+	static const char* const ColumnNames[3] = { "min", "avg", "max" };
+
+	const word lineHeight = ConFont->GetHeight();
+	word x = 0;
+	word y = fpscounter ? lineHeight + 1 : 0;
+	word width = ValueColumns[2] + 2;
+	word height = (NUM_PROFILE_STAGES + 2)*lineHeight + 1;
+	const word top = y;
+	MenuToRealCoords(x, y, width, height, MENU_TOP);
+	VWB_Clear(GPalette.BlackIndex, x, y, x+width, y+height);
+
+	pa = MENU_TOP;
+	FString value;
+	word vwidth, vheight;
+
+	py = top;
+	px = 2;
+	VWB_DrawPropString(ConFont, "ms", CR_GOLD);
+	for(unsigned int c = 0;c < 3;++c)
+	{
+		VW_MeasurePropString(ConFont, ColumnNames[c], vwidth, vheight);
+		px = ValueColumns[c] - vwidth;
+		VWB_DrawPropString(ConFont, ColumnNames[c], CR_GOLD);
+	}
+
+	for(unsigned int i = 0;i <= NUM_PROFILE_STAGES;++i)
+	{
+		float minimum = Samples[0][i], maximum = Samples[0][i], total = 0;
+		for(unsigned int s = 0;s < NumSamples;++s)
+		{
+			const float ms = Samples[s][i];
+			if(ms < minimum) minimum = ms;
+			if(ms > maximum) maximum = ms;
+			total += ms;
+		}
+		const float stats[3] = { minimum, total/NumSamples, maximum };
+
+		py = top + (i+1)*lineHeight;
+		px = 2;
+		VWB_DrawPropString(ConFont, StageNames[i], i == NUM_PROFILE_STAGES ? CR_GOLD : CR_WHITE);
+		for(unsigned int c = 0;c < 3;++c)
+		{
+			value.Format("%.2f", stats[c]);
+			VW_MeasurePropString(ConFont, value, vwidth, vheight);
+			px = ValueColumns[c] - vwidth;
+			VWB_DrawPropString(ConFont, value, CR_WHITE);
+		}
+	}
+
+	// Registered stats go underneath, each on its own background.
+	word staty = top + (NUM_PROFILE_STAGES + 2)*lineHeight + 1;
+	for(FStat* stat = FStat::GetFirst();stat;stat = stat->GetNext())
+	{
+		value = stat->GetStats();
+		if(value.IsEmpty())
+			continue;
+		VW_MeasurePropString(ConFont, value, vwidth, vheight);
+
+		x = 0;
+		y = staty;
+		width = vwidth + 3;
+		height = vheight + 1;
+		MenuToRealCoords(x, y, width, height, MENU_TOP);
+		VWB_Clear(GPalette.BlackIndex, x, y, x+width, y+height);
+
+		px = 2;
+		py = staty;
+		VWB_DrawPropString(ConFont, value, CR_GRAY);
+		staty += vheight + 1;
+	}
+
+	pa = MENU_CENTER;
+}
+
+}
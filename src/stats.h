@@ -0,0 +1,165 @@
+/*
+** stats.h
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Lightweight frame profiler. Each stage of a frame accumulates time into
+** a cycle_t which is folded into a sliding window at the end of the frame.
+**
+*/
+
+#ifndef __STATS_H__
+#define __STATS_H__
+
+#include "wl_def.h"
+#include "zstring.h"
+
+// Reads the high resolution timer. Units are given by PerfToMillisec which
+// is valid once I_InitClock has been called.
+void I_InitClock();
+QWORD I_ClockNow();
+extern double PerfToSec, PerfToMillisec;
+
+class cycle_t
+{
+public:
+	cycle_t() : Counter(0) {}
+
+	void Reset() { Counter = 0; }
+	void Clock() { Counter -= I_ClockNow(); }
+	void Unclock() { Counter += I_ClockNow(); }
+
+	double Time() const { return Counter * PerfToSec; }
+	double TimeMS() const { return Counter * PerfToMillisec; }
+
+private:
+	SQWORD Counter;
+};
+
+enum EProfileStage
+{
+	PROF_Walls,
+	PROF_Floors,
+	PROF_Skies,
+	PROF_Sprites,
+	PROF_Weapon,
+	PROF_StatusBar,
+	PROF_Thinkers,
+	PROF_GC,
+	PROF_Present,
+
+	NUM_PROFILE_STAGES
+};
+
+// Registers a named block of text which is shown below the profiler
+// overlay. Used through ADD_STAT as in ZDoom.
+class FStat
+{
+public:
+	FStat(const char* name);
+	virtual ~FStat();
+
+	virtual FString GetStats() = 0;
+
+	const char* GetName() const { return Name; }
+	FStat* GetNext() const { return Next; }
+	static FStat* GetFirst() { return FirstStat; }
+
+private:
+	const char* Name;
+	FStat* Next;
+
+	static FStat* FirstStat;
+};
+
+#define ADD_STAT(n) \
+	static class Stat_##n : public FStat \
+	{ \
+	public: \
+		Stat_##n () : FStat (#n) {} \
+		FString GetStats (); \
+	} Istaticstat##n; \
+	FString Stat_##n::GetStats ()
+
+class FProfileScope;
+
+namespace Profiler {
+
+// Number of frames which min/avg/max are computed over.
+enum { WINDOW_SIZE = 70 };
+
+extern bool Active;
+extern bool ShowOverlay;
+extern cycle_t Cycles[NUM_PROFILE_STAGES];
+extern FProfileScope* CurrentScope;
+
+void DrawOverlay();
+void EndFrame();
+bool OpenCSV(const char* filename);
+void Resync();
+void SetOverlay(bool show);
+
+}
+
+// Times the enclosing scope under the given stage while the profiler is
+// collecting. The state is latched so a toggle mid-scope stays balanced.
+// Scopes may nest, in which case the outer stage is paused so that each
+// stage only counts its own time.
+class FProfileScope
+{
+public:
+	FProfileScope(EProfileStage stage) : Stage(stage), Timing(Profiler::Active)
+	{
+		if(Timing)
+		{
+			Parent = Profiler::CurrentScope;
+			Profiler::CurrentScope = this;
+			if(Parent)
+				Profiler::Cycles[Parent->Stage].Unclock();
+			Profiler::Cycles[Stage].Clock();
+		}
+	}
+	~FProfileScope()
+	{
+		if(Timing)
+		{
+			Profiler::Cycles[Stage].Unclock();
+			if(Parent)
+				Profiler::Cycles[Parent->Stage].Clock();
+			Profiler::CurrentScope = Parent;
+		}
+	}
+
+private:
+	EProfileStage Stage;
+	bool Timing;
+	FProfileScope* Parent;
+};
+
+#endif
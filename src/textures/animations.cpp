@@ -908,6 +908,7 @@ void FTextureManager::UpdateAnimations (DWORD mstime)
 				break;
 			}
 			anim->SetSwitchTime (mstime);
+			++AnimationSerial;
 		}
 
 		if (anim->AnimType == FAnimDef::ANIM_DiscreteFrames)
@@ -69,7 +69,7 @@ FTextureManager TexMan;
 //
 //==========================================================================
 
-FTextureManager::FTextureManager ()
+FTextureManager::FTextureManager () : AnimationSerial(0)
 {
 	memset (HashFirst, -1, sizeof(HashFirst));
 
@@ -1258,6 +1258,18 @@ void FTextureManager::PrecacheLevel (void)
 	memset (hitlist, 0, cnt);
 
 	map->GetHitlist(hitlist+1);
+
+	// Get any compressed lumps decoded together before going through them.
+	TArray<int> lumps;
+	for (int i = cnt - 1; i > 0; i--)
+	{
+		int lump;
+		if (hitlist[i] && (lump = ByIndex(i-1)->GetSourceLump()) >= 0)
+			lumps.Push(lump);
+	}
+	FLumpBatch batch;
+	Wads.CacheLumpBatch(lumps, batch);
+
 	unsigned int numcached = 0;
 	for (int i = cnt - 1; i > 0; i--)
 	{
@@ -408,6 +408,8 @@ public:
 	int ReadTexture (FArchive &arc);
 
 	void UpdateAnimations (DWORD mstime);
+	// Changes whenever an animation has advanced a frame.
+	unsigned int GetAnimationSerial () const { return AnimationSerial; }
 	int GuesstimateNumTextures ();
 
 	FSwitchDef *FindSwitch (FTextureID texture);
@@ -472,6 +474,7 @@ private:
 	TMap<int,int> PalettedVersions;		// maps from normal -> paletted version
 
 	TArray<FAnimDef *> mAnimations;
+	unsigned int AnimationSerial;
 	TArray<FSwitchDef *> mSwitchDefs;
 	TArray<FDoorAnimation> mAnimatedDoors;
 	TArray<BYTE *> BuildTileFiles;
@@ -34,6 +34,7 @@
 
 #include "actor.h"
 #include "a_inventory.h"
+#include "dobjpool.h"
 #include "doomerrors.h"
 #include "id_ca.h"
 #include "lnspec.h"
@@ -489,6 +490,7 @@ static bool g_ThingEdNumWarning;
 ClassDef::ClassDef() : tentative(false)
 {
 	defaultInstance = NULL;
+	pool = NULL;
 	FlatPointers = Pointers = NULL;
 	replacement = replacee = NULL;
 }
@@ -499,6 +501,9 @@ ClassDef::~ClassDef()
 	{
 		M_Free(defaultInstance);
 	}
+	// If something leaked an instance the slab has to outlive us.
+	if(pool && pool->GetUsed() == 0)
+		delete pool;
 	for(unsigned int i = 0;i < symbols.Size();++i)
 		delete symbols[i];
 }
@@ -607,7 +612,10 @@ AActor *ClassDef::CreateInstance() const
 		((AActor*)defaultInstance)->SeeState = FindState(NAME_See);
 	}
 
-	AActor *newactor = (AActor *) M_Malloc(size);
+	if(!pool)
+		pool = new FObjectPool(size);
+
+	AActor *newactor = (AActor *) pool->Alloc();
 	memcpy((void*)newactor, (void*)defaultInstance, size);
 	ConstructNative(this, newactor);
 	newactor->Init();
@@ -347,6 +347,7 @@ class ClassDef
 
 		DObject			*defaultInstance;
 		DObject			*(*ConstructNative)(const ClassDef *, void *);
+		mutable FObjectPool	*pool;			// created on first CreateInstance
 
 		static bool		bShutdown;
 };
@@ -34,9 +34,21 @@
 
 #include "wl_def.h"
 //#include "i_system.h"
+#include "tarray.h"
 #include "v_palette.h"
 #include "v_pfx.h"
 
+#if defined(_M_X64) || defined(_M_IX86) || defined(__i386__) || defined(__amd64__)
+#define PFX_SIMD
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PFX_TARGET(x)
+#else
+#define PFX_TARGET(x) __attribute__((target(x)))
+#endif
+#include <immintrin.h>
+#endif
+
 extern "C"
 {
 	PfxUnion GPfxPal;
@@ -68,6 +80,8 @@ static void Convert32 (BYTE *src, int srcpitch,
 	void *destin, int destpitch, int destwidth, int destheight,
 	fixed_t xstep, fixed_t ystep, fixed_t xfrac, fixed_t yfrac);
 
+static PfxConverter GetConvert32 (EPfxPath path);
+
 void PfxState::SetFormat (int bits, uint32 redMask, uint32 greenMask, uint32 blueMask)
 {
 	switch (bits)
@@ -131,7 +145,7 @@ void PfxState::SetFormat (int bits, uint32 redMask, uint32 greenMask, uint32 blu
 		{
 			SetPalette = Palette32Generic;
 		}
-		Convert = Convert32;
+		Convert = GetConvert32 (V_GetBestPfxPath ());
 		Masks.Bits32.Red = redMask;
 		Masks.Bits32.Green = greenMask;
 		Masks.Bits32.Blue = blueMask;
@@ -689,3 +703,369 @@ static void Convert32 (BYTE *src, int srcpitch,
 		}
 	}
 }
+
+// SIMD converters ---------------------------------------------------------
+//
+// A 256 entry table lookup can't be vectorized without gathers, which are
+// slower than plain loads on most hardware, so the palette lookups are still
+// done one at a time. The vector units are used to assemble the pixels and
+// write them out with non-temporal stores, since the destination is normally
+// a texture upload buffer that is never read back. For scaled output each
+// source row is expanded once into a cached row which is then streamed to
+// every destination row that samples it.
+
+static TArray<int> PfxColumns;
+static TArray<DWORD> PfxRow;
+
+static const int *PfxColumnTable (int destwidth, fixed_t xstep, fixed_t xfrac)
+{
+	PfxColumns.Resize (destwidth);
+	for (int x = 0; x < destwidth; ++x, xfrac += xstep)
+	{
+		PfxColumns[x] = xfrac >> FRACBITS;
+	}
+	return &PfxColumns[0];
+}
+
+#ifdef PFX_SIMD
+struct PfxSSE2
+{
+	PFX_TARGET("sse2") static void ConvertRow (DWORD *dest, const BYTE *src, int width)
+	{
+		const DWORD *pal = GPfxPal.Pal32;
+
+		while (((size_t)dest & 15) && width != 0)
+		{
+			*dest++ = pal[*src++];
+			width--;
+		}
+		for (int x = width >> 2; x != 0; x--)
+		{
+			DWORD quad;
+			memcpy (&quad, src, 4);
+			_mm_stream_si128 ((__m128i *)dest, _mm_setr_epi32 (
+				pal[quad & 0xFF], pal[(quad >> 8) & 0xFF],
+				pal[(quad >> 16) & 0xFF], pal[quad >> 24]));
+			dest += 4;
+			src += 4;
+		}
+		for (width &= 3; width != 0; width--)
+		{
+			*dest++ = pal[*src++];
+		}
+	}
+
+	PFX_TARGET("sse2") static void ScaleRow (DWORD *dest, const BYTE *src, const int *cols, int width)
+	{
+		const DWORD *pal = GPfxPal.Pal32;
+
+		for (int x = width >> 2; x != 0; x--)
+		{
+			_mm_storeu_si128 ((__m128i *)dest, _mm_setr_epi32 (
+				pal[src[cols[0]]], pal[src[cols[1]]],
+				pal[src[cols[2]]], pal[src[cols[3]]]));
+			dest += 4;
+			cols += 4;
+		}
+		for (width &= 3; width != 0; width--)
+		{
+			*dest++ = pal[src[*cols++]];
+		}
+	}
+
+	PFX_TARGET("sse2") static void StreamRow (DWORD *dest, const DWORD *src, int width)
+	{
+		while (((size_t)dest & 15) && width != 0)
+		{
+			*dest++ = *src++;
+			width--;
+		}
+		for (int x = width >> 2; x != 0; x--)
+		{
+			_mm_stream_si128 ((__m128i *)dest, _mm_loadu_si128 ((const __m128i *)src));
+			dest += 4;
+			src += 4;
+		}
+		for (width &= 3; width != 0; width--)
+		{
+			*dest++ = *src++;
+		}
+	}
+
+	PFX_TARGET("sse2") static void Fence ()
+	{
+		_mm_sfence ();
+	}
+};
+
+struct PfxAVX2
+{
+	PFX_TARGET("avx2") static void ConvertRow (DWORD *dest, const BYTE *src, int width)
+	{
+		const DWORD *pal = GPfxPal.Pal32;
+
+		while (((size_t)dest & 31) && width != 0)
+		{
+			*dest++ = pal[*src++];
+			width--;
+		}
+		for (int x = width >> 3; x != 0; x--)
+		{
+			DWORD lo, hi;
+			memcpy (&lo, src, 4);
+			memcpy (&hi, src + 4, 4);
+			_mm256_stream_si256 ((__m256i *)dest, _mm256_setr_epi32 (
+				pal[lo & 0xFF], pal[(lo >> 8) & 0xFF],
+				pal[(lo >> 16) & 0xFF], pal[lo >> 24],
+				pal[hi & 0xFF], pal[(hi >> 8) & 0xFF],
+				pal[(hi >> 16) & 0xFF], pal[hi >> 24]));
+			dest += 8;
+			src += 8;
+		}
+		for (width &= 7; width != 0; width--)
+		{
+			*dest++ = pal[*src++];
+		}
+	}
+
+	PFX_TARGET("avx2") static void ScaleRow (DWORD *dest, const BYTE *src, const int *cols, int width)
+	{
+		const DWORD *pal = GPfxPal.Pal32;
+
+		for (int x = width >> 3; x != 0; x--)
+		{
+			_mm256_storeu_si256 ((__m256i *)dest, _mm256_setr_epi32 (
+				pal[src[cols[0]]], pal[src[cols[1]]],
+				pal[src[cols[2]]], pal[src[cols[3]]],
+				pal[src[cols[4]]], pal[src[cols[5]]],
+				pal[src[cols[6]]], pal[src[cols[7]]]));
+			dest += 8;
+			cols += 8;
+		}
+		for (width &= 7; width != 0; width--)
+		{
+			*dest++ = pal[src[*cols++]];
+		}
+	}
+
+	PFX_TARGET("avx2") static void StreamRow (DWORD *dest, const DWORD *src, int width)
+	{
+		while (((size_t)dest & 31) && width != 0)
+		{
+			*dest++ = *src++;
+			width--;
+		}
+		for (int x = width >> 3; x != 0; x--)
+		{
+			_mm256_stream_si256 ((__m256i *)dest, _mm256_loadu_si256 ((const __m256i *)src));
+			dest += 8;
+			src += 8;
+		}
+		for (width &= 7; width != 0; width--)
+		{
+			*dest++ = *src++;
+		}
+	}
+
+	PFX_TARGET("avx2") static void Fence ()
+	{
+		_mm_sfence ();
+	}
+};
+
+template<class Rows>
+static void Convert32_SIMD (BYTE *src, int srcpitch,
+	void *destin, int destpitch, int destwidth, int destheight,
+	fixed_t xstep, fixed_t ystep, fixed_t xfrac, fixed_t yfrac)
+{
+	if ((destwidth | destheight) == 0)
+	{
+		return;
+	}
+
+	BYTE *dest = (BYTE *)destin;
+	int y;
+
+	if (xstep == FRACUNIT && ystep == FRACUNIT)
+	{
+		for (y = destheight; y != 0; y--)
+		{
+			Rows::ConvertRow ((DWORD *)dest, src, destwidth);
+			dest += destpitch;
+			src += srcpitch;
+		}
+	}
+	else
+	{
+		const int *cols = PfxColumnTable (destwidth, xstep, xfrac);
+		PfxRow.Resize (destwidth);
+		DWORD *row = &PfxRow[0];
+		const BYTE *rowsrc = NULL;
+
+		for (y = destheight; y != 0; y--)
+		{
+			if (src != rowsrc)
+			{
+				Rows::ScaleRow (row, src, cols, destwidth);
+				rowsrc = src;
+			}
+			Rows::StreamRow ((DWORD *)dest, row, destwidth);
+			yfrac += ystep;
+			while (yfrac >= FRACUNIT)
+			{
+				yfrac -= FRACUNIT;
+				src += srcpitch;
+			}
+			dest += destpitch;
+		}
+	}
+	Rows::Fence ();
+}
+#endif
+
+static PfxConverter GetConvert32 (EPfxPath path)
+{
+	switch (path)
+	{
+#ifdef PFX_SIMD
+	case PFX_AVX2:
+		return Convert32_SIMD<PfxAVX2>;
+	case PFX_SSE2:
+		return Convert32_SIMD<PfxSSE2>;
+#endif
+	default:
+		return Convert32;
+	}
+}
+
+bool V_PfxPathAvailable (EPfxPath path)
+{
+#ifdef PFX_SIMD
+	static bool checked = false;
+	static bool hasSSE2, hasAVX2;
+
+	if (!checked)
+	{
+		checked = true;
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid (info, 0);
+		const int maxleaf = info[0];
+		__cpuid (info, 1);
+		hasSSE2 = (info[3] & (1<<26)) != 0;
+		// AVX requires OS support for saving the YMM registers
+		hasAVX2 = false;
+		if (maxleaf >= 7 && (info[2] & (1<<27)) && (info[2] & (1<<28)) && (_xgetbv (0) & 6) == 6)
+		{
+			__cpuidex (info, 7, 0);
+			hasAVX2 = (info[1] & (1<<5)) != 0;
+		}
+#else
+		__builtin_cpu_init ();
+		hasSSE2 = __builtin_cpu_supports ("sse2") != 0;
+		hasAVX2 = __builtin_cpu_supports ("avx2") != 0;
+#endif
+	}
+
+	switch (path)
+	{
+	case PFX_SSE2: return hasSSE2;
+	case PFX_AVX2: return hasAVX2;
+	default: break;
+	}
+#endif
+	return path == PFX_Scalar;
+}
+
+EPfxPath V_GetBestPfxPath ()
+{
+	for (int i = NUM_PFX_PATHS-1; i > PFX_Scalar; --i)
+	{
+		if (V_PfxPathAvailable ((EPfxPath)i))
+			return (EPfxPath)i;
+	}
+	return PFX_Scalar;
+}
+
+// Benchmark ---------------------------------------------------------------
+//
+// Times each available 32-bit converter for a 4K output at a few common
+// scale factors and checks the results against the scalar converter.
+
+void V_BenchmarkPfx ()
+{
+	static const char *const PathNames[NUM_PFX_PATHS] = { "scalar", "SSE2", "AVX2" };
+	static const struct
+	{
+		const char *Name;
+		int SrcWidth, SrcHeight;
+		fixed_t Step;
+	} Cases[] =
+	{
+		{ "1:1", 3840, 2160, FRACUNIT },
+		{ "2x", 1920, 1080, FRACUNIT/2 },
+		{ "1.5x", 2560, 1440, FRACUNIT*2/3 }
+	};
+	const int DestWidth = 3840, DestHeight = 2160;
+	const int Frames = 60;
+
+	DWORD savedpal[256];
+	memcpy (savedpal, GPfxPal.Pal32, sizeof(savedpal));
+
+	DWORD seed = 0x1234567;
+	for (int i = 0; i < 256; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		GPfxPal.Pal32[i] = seed;
+	}
+
+	BYTE *src = new BYTE[DestWidth*DestHeight];
+	for (int i = 0; i < DestWidth*DestHeight; ++i)
+	{
+		seed = seed * 1664525 + 1013904223;
+		src[i] = (BYTE)(seed >> 24);
+	}
+	DWORD *reference = new DWORD[DestWidth*DestHeight];
+	DWORD *dest = new DWORD[DestWidth*DestHeight];
+
+	Printf ("Palette conversion benchmark (%dx%d, 32-bit, %d frames)\n", DestWidth, DestHeight, Frames);
+	for (unsigned int c = 0; c < countof(Cases); ++c)
+	{
+		Printf ("%s (%dx%d source):\n", Cases[c].Name, Cases[c].SrcWidth, Cases[c].SrcHeight);
+
+		Convert32 (src, Cases[c].SrcWidth, reference, DestWidth*4, DestWidth, DestHeight,
+			Cases[c].Step, Cases[c].Step, 0, 0);
+
+		double basetime = 0;
+		for (int p = PFX_Scalar; p < NUM_PFX_PATHS; ++p)
+		{
+			if (!V_PfxPathAvailable ((EPfxPath)p))
+			{
+				Printf ("  %-7s unavailable\n", PathNames[p]);
+				continue;
+			}
+
+			PfxConverter convert = GetConvert32 ((EPfxPath)p);
+			memset (dest, 0, DestWidth*DestHeight*4);
+
+			Uint32 start = SDL_GetTicks ();
+			for (int f = 0; f < Frames; ++f)
+			{
+				convert (src, Cases[c].SrcWidth, dest, DestWidth*4, DestWidth, DestHeight,
+					Cases[c].Step, Cases[c].Step, 0, 0);
+			}
+			double frametime = double(SDL_GetTicks () - start) / Frames;
+			if (p == PFX_Scalar)
+				basetime = frametime;
+
+			Printf ("  %-7s %7.3f ms/frame  %5.2fx%s\n", PathNames[p], frametime,
+				frametime > 0 ? basetime / frametime : 0.,
+				memcmp (dest, reference, DestWidth*DestHeight*4) != 0 ? "  MISMATCH" : "");
+		}
+	}
+
+	delete[] dest;
+	delete[] reference;
+	delete[] src;
+	memcpy (GPfxPal.Pal32, savedpal, sizeof(savedpal));
+}
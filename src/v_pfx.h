@@ -46,6 +46,21 @@ union PfxUnion
 	BYTE Pal24[256][4];
 };
 
+typedef void (*PfxConverter) (BYTE *src, int srcpitch,
+	void *dest, int destpitch, int destwidth, int destheight,
+	fixed_t xstep, fixed_t ystep, fixed_t xfrac, fixed_t yfrac);
+
+// Implementations available for 32-bit conversion. The best one supported by
+// the CPU is picked at runtime.
+enum EPfxPath
+{
+	PFX_Scalar,
+	PFX_SSE2,
+	PFX_AVX2,
+
+	NUM_PFX_PATHS
+};
+
 struct PfxState
 {
 	union
@@ -72,9 +87,7 @@ struct PfxState
 
 	void SetFormat (int bits, uint32 redMask, uint32 greenMask, uint32 blueMask);
 	void (*SetPalette) (const PalEntry *pal);
-	void (*Convert) (BYTE *src, int srcpitch,
-		void *dest, int destpitch, int destwidth, int destheight,
-		fixed_t xstep, fixed_t ystep, fixed_t xfrac, fixed_t yfrac);
+	PfxConverter Convert;
 };
 
 extern "C"
@@ -83,4 +96,8 @@ extern "C"
 	extern PfxState GPfx;
 }
 
+bool V_PfxPathAvailable (EPfxPath path);
+EPfxPath V_GetBestPfxPath ();
+void V_BenchmarkPfx ();
+
 #endif //__V_PFX_H__
@@ -49,6 +49,7 @@
 #include "resourcefiles/resourcefile.h"
 #include "zdoomsupport.h"
 #include "filesys.h"
+#include <SDL.h>
 
 // Work around missing defines for ECWolf
 #ifndef PATH_MAX
@@ -238,15 +239,24 @@ void FWadCollection::AddFile (const char *filename, FileReader *wadinfo)
 
 		if (!isdir)
 		{
-			try
+			// Map local files where we can so stored lumps don't need
+			// to be read into their own buffers.
+			MappedFileReader *mapped = new MappedFileReader;
+			if (mapped->Open(filename))
+				wadinfo = mapped;
+			else
 			{
-				wadinfo = new FileReader(filename);
-			}
-			catch (CRecoverableError &err)
-			{ // Didn't find file
-				Printf (TEXTCOLOR_RED "%s\n", err.GetMessage());
-				PrintLastError ();
-				return;
+				delete mapped;
+				try
+				{
+					wadinfo = new FileReader(filename);
+				}
+				catch (CRecoverableError &err)
+				{ // Didn't find file
+					Printf (TEXTCOLOR_RED "%s\n", err.GetMessage());
+					PrintLastError ();
+					return;
+				}
 			}
 		}
 	}
@@ -1095,6 +1105,263 @@ FWadLump *FWadCollection::ReopenLumpNum (int lump)
 	return new FWadLump(LumpInfo[lump].lump, true);
 }
 
+//==========================================================================
+//
+// ReopenLumpNumNewFile
+//
+// Opens the lump's archive again so that it can be read without caching
+// the lump or sharing the archive's file position, which makes it safe to
+// read from another thread. Only works for lumps stored uncompressed in a
+// file read from disk, otherwise NULL is returned and the lump must be read
+// normally (or through GetStoredLumpData).
+//
+//==========================================================================
+
+FileReader *FWadCollection::ReopenLumpNumNewFile (int lump)
+{
+	if ((unsigned)lump >= (unsigned)LumpInfo.Size() ||
+		!LumpInfo[lump].lump->IsStored() ||
+		LumpInfo[lump].lump->GetFileOffset() < 0 ||
+		Files[LumpInfo[lump].wadnum]->GetReader()->GetFile() == NULL)
+	{
+		return NULL;
+	}
+
+	FILE *f = File(Files[LumpInfo[lump].wadnum]->Filename).open("rb");
+	if (f == NULL)
+	{
+		return NULL;
+	}
+	fseek(f, LumpInfo[lump].lump->GetFileOffset(), SEEK_SET);
+	return new FileReader(f, LumpInfo[lump].lump->LumpSize);
+}
+
+//==========================================================================
+//
+// GetStoredLumpData
+//
+// Returns the lump's data in place if it is stored uncompressed in an
+// archive held in memory (a mapped file or a wad inside another archive).
+// The data stays valid for as long as the archive is loaded and may be
+// read from any thread. Returns NULL for anything else.
+//
+//==========================================================================
+
+const char *FWadCollection::GetStoredLumpData (int lump) const
+{
+	if ((unsigned)lump >= (unsigned)LumpInfo.Size() ||
+		!LumpInfo[lump].lump->IsStored() ||
+		LumpInfo[lump].lump->GetFileOffset() < 0)
+	{
+		return NULL;
+	}
+
+	FResourceLump *res = LumpInfo[lump].lump;
+	return Files[LumpInfo[lump].wadnum]->GetBufferRange(res->GetFileOffset(), res->LumpSize);
+}
+
+//==========================================================================
+//
+// CacheLumpBatch
+//
+// Caches compressed lumps ahead of a loader which will go through them
+// one at a time. Lumps which can be decoded independently are spread over
+// worker threads. Ones tied to their archive (solid 7z) are all filled in
+// archive order by whichever worker gets to them first. Everything else is
+// left to be loaded when it's read.
+//
+//==========================================================================
+
+struct FBatchDecode
+{
+	FResourceLump *lump;
+	const char *data;
+	long length;
+	TArray<char> storage;
+	char *dest;
+};
+
+struct FBatchSerial
+{
+	FResourceLump *lump;
+	int order;
+};
+
+struct FBatchState
+{
+	TArray<FBatchDecode> Decodes;
+	TArray<FBatchSerial> Serial;
+	unsigned int NextDecode;
+	bool SerialTaken;
+	SDL_mutex *Lock;
+};
+
+static int STACK_ARGS batchlumpcmp (const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+static int STACK_ARGS batchserialcmp (const void *a, const void *b)
+{
+	const FBatchSerial *sa = (const FBatchSerial *)a;
+	const FBatchSerial *sb = (const FBatchSerial *)b;
+	if (sa->lump->Owner != sb->lump->Owner)
+		return sa->lump->Owner < sb->lump->Owner ? -1 : 1;
+	return sa->order - sb->order;
+}
+
+static int BatchWorker (void *data)
+{
+	FBatchState &state = *static_cast<FBatchState *>(data);
+
+	// Errors are left for the lump to report again when it's read on the
+	// main thread.
+	for (;;)
+	{
+		SDL_LockMutex(state.Lock);
+		if (!state.SerialTaken && state.Serial.Size() > 0)
+		{
+			state.SerialTaken = true;
+			SDL_UnlockMutex(state.Lock);
+
+			for (unsigned int i = 0; i < state.Serial.Size(); ++i)
+			{
+				try
+				{
+					state.Serial[i].lump->CacheLump();
+				}
+				catch (...)
+				{
+				}
+			}
+			continue;
+		}
+		if (state.NextDecode >= state.Decodes.Size())
+		{
+			SDL_UnlockMutex(state.Lock);
+			break;
+		}
+		FBatchDecode &job = state.Decodes[state.NextDecode++];
+		SDL_UnlockMutex(state.Lock);
+
+		job.dest = new char[job.lump->LumpSize];
+		try
+		{
+			job.lump->DecodeCache(job.data, job.length, job.dest);
+		}
+		catch (...)
+		{
+			delete[] job.dest;
+			job.dest = NULL;
+		}
+	}
+	return 0;
+}
+
+void FWadCollection::CacheLumpBatch (const TArray<int> &lumps, FLumpBatch &batch)
+{
+	enum { MAX_WORKERS = 8 };
+
+	FBatchState state;
+	state.NextDecode = 0;
+	state.SerialTaken = false;
+
+	// The same lump may be asked for more than once.
+	TArray<int> sorted(lumps);
+	if (sorted.Size() > 1)
+		qsort(&sorted[0], sorted.Size(), sizeof(int), batchlumpcmp);
+
+	for (unsigned int i = 0; i < sorted.Size(); ++i)
+	{
+		if ((unsigned)sorted[i] >= LumpInfo.Size() || (i > 0 && sorted[i] == sorted[i-1]))
+			continue;
+
+		FResourceLump *lump = LumpInfo[sorted[i]].lump;
+		if (lump->Cache != NULL)
+			continue;
+
+		FBatchDecode &job = state.Decodes[state.Decodes.Reserve(1)];
+		if (lump->ReadEncoded(job.data, job.length, job.storage))
+		{
+			job.lump = lump;
+			job.dest = NULL;
+			continue;
+		}
+		state.Decodes.Resize(state.Decodes.Size() - 1);
+
+		const int order = lump->GetSerialOrder();
+		if (order >= 0)
+		{
+			FBatchSerial serial = { lump, order };
+			state.Serial.Push(serial);
+		}
+	}
+
+	if (state.Serial.Size() > 1)
+	{
+		qsort(&state.Serial[0], state.Serial.Size(), sizeof(FBatchSerial), batchserialcmp);
+	}
+
+	const unsigned int numJobs = state.Decodes.Size() + (state.Serial.Size() > 0);
+	if (numJobs == 0)
+		return;
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+	const unsigned int cpus = MAX(SDL_GetCPUCount(), 1);
+#else
+	const unsigned int cpus = 2;
+#endif
+	const unsigned int numWorkers = MIN<unsigned int>(MIN<unsigned int>(cpus, MAX_WORKERS), numJobs) - 1;
+
+	// The main thread does its share as well.
+	SDL_Thread *workers[MAX_WORKERS];
+	unsigned int numStarted = 0;
+	state.Lock = numWorkers > 0 ? SDL_CreateMutex() : NULL;
+	if (state.Lock != NULL)
+	{
+		for (; numStarted < numWorkers; ++numStarted)
+		{
+#if SDL_VERSION_ATLEAST(2,0,0)
+			workers[numStarted] = SDL_CreateThread(BatchWorker, "LumpBatch", &state);
+#else
+			workers[numStarted] = SDL_CreateThread(BatchWorker, &state);
+#endif
+			if (workers[numStarted] == NULL)
+				break;
+		}
+	}
+	BatchWorker(&state);
+	for (unsigned int i = 0; i < numStarted; ++i)
+		SDL_WaitThread(workers[i], NULL);
+	if (state.Lock != NULL)
+		SDL_DestroyMutex(state.Lock);
+
+	for (unsigned int i = 0; i < state.Decodes.Size(); ++i)
+	{
+		FBatchDecode &job = state.Decodes[i];
+		if (job.dest != NULL && job.lump->Cache == NULL)
+		{
+			job.lump->Cache = job.dest;
+			job.lump->RefCount = 1;
+			batch.Lumps.Push(job.lump);
+		}
+		else
+			delete[] job.dest;
+	}
+	for (unsigned int i = 0; i < state.Serial.Size(); ++i)
+	{
+		FResourceLump *lump = state.Serial[i].lump;
+		if (lump->Cache != NULL && lump->RefCount > 0)
+			batch.Lumps.Push(lump);
+	}
+}
+
+FLumpBatch::~FLumpBatch ()
+{
+	for (unsigned int i = 0; i < Lumps.Size(); ++i)
+		Lumps[i]->ReleaseCache();
+}
+
 //==========================================================================
 //
 // GetFileReader
@@ -1336,6 +1603,11 @@ long FWadLump::Read (void *buffer, long len)
 	return numread;
 }
 
+const char *FWadLump::GetBuffer() const
+{
+	return Lump != NULL ? Lump->Cache : NULL;
+}
+
 char *FWadLump::Gets(char *strbuf, int len)
 {
 	if (Lump != NULL)
@@ -112,6 +112,7 @@ public:
 	long Seek (long offset, int origin);
 	long Read (void *buffer, long len);
 	char *Gets(char *strbuf, int len);
+	const char *GetBuffer() const;
 
 private:
 	FWadLump (FResourceLump *Lump, bool alwayscache = false);
@@ -121,6 +122,24 @@ private:
 	friend class FWadCollection;
 };
 
+// Lumps cached together by FWadCollection::CacheLumpBatch. They stay in
+// memory until this is destroyed, so a loader can keep one around while it
+// goes through the lumps one at a time.
+class FLumpBatch
+{
+public:
+	FLumpBatch () {}
+	~FLumpBatch ();
+
+private:
+	TArray<FResourceLump *> Lumps;
+
+	FLumpBatch (const FLumpBatch &);
+	FLumpBatch &operator= (const FLumpBatch &);
+
+	friend class FWadCollection;
+};
+
 
 // A lump in memory.
 class FMemLump
@@ -188,6 +207,9 @@ public:
 	FWadLump OpenLumpNum (int lump);
 	FWadLump OpenLumpName (const char *name) { return OpenLumpNum (GetNumForName (name)); }
 	FWadLump *ReopenLumpNum (int lump);	// Opens a new, independent FILE
+	FileReader *ReopenLumpNumNewFile (int lump);	// Opens a new FILE on the lump's archive, NULL if it isn't stored uncompressed
+	const char *GetStoredLumpData (int lump) const;	// Stored lump in an archive held in memory, NULL otherwise
+	void CacheLumpBatch (const TArray<int> &lumps, FLumpBatch &batch);	// Decompresses lumps in parallel
 	
 	FileReader * GetFileReader(int wadnum);	// Gets a FileReader object to the entire WAD
 
@@ -31,6 +31,7 @@
 #include "r_sprites.h"
 #include "wl_shade.h"
 #include "filesys.h"
+#include "stats.h"
 
 #ifdef USE_CLOUDSKY
 #include "wl_cloudsky.h"
@@ -377,6 +378,18 @@ int DebugKeys (void)
 	}
 	else if (Keyboard[sc_Q])        // Q = fast quit
 		Quit (NULL);
+	else if (Keyboard[sc_R])        // R = frame profiler
+	{
+		US_CenterWindow (22,2);
+		if (Profiler::ShowOverlay)
+			US_PrintCentered ("Frame Profiler OFF");
+		else
+			US_PrintCentered ("Frame Profiler ON");
+		VW_UpdateScreen();
+		IN_Ack();
+		Profiler::SetOverlay(!Profiler::ShowOverlay);
+		return 1;
+	}
 	else if (Keyboard[sc_S])        // S = slow motion
 	{
 		US_CenterWindow(30,3);
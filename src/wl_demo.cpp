@@ -0,0 +1,285 @@
+/*
+** wl_demo.cpp
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+*/
+
+#include "wl_def.h"
+#include "files.h"
+#include "templates.h"
+#include "wl_demo.h"
+#include "wl_play.h"
+
+// Write out what we have this often so an interrupted recording only loses
+// the last few seconds.
+#define DEMO_FLUSHTICS (TICRATE*5)
+
+// Each tic is stored as 32 bits of button state and 8 bits of automap
+// button state followed by the five control axes as 16-bit values, all
+// little endian.
+enum { DEMO_TICSIZE = 4 + 1 + 5*2 };
+
+static void WriteShort(BYTE *&out, int value)
+{
+	const SWORD v = static_cast<SWORD>(clamp<int>(value, -32768, 32767));
+	*out++ = v&0xFF;
+	*out++ = (v>>8)&0xFF;
+}
+
+static int ReadShort(const BYTE *&in)
+{
+	const SWORD v = static_cast<SWORD>(in[0]|(in[1]<<8));
+	in += 2;
+	return v;
+}
+
+static void PackTic(BYTE *out, const TicCmd_t &cmd)
+{
+	DWORD buttons = 0;
+	for(unsigned int i = 0;i < NUMBUTTONS;++i)
+	{
+		if(cmd.buttonstate[i])
+			buttons |= 1u<<i;
+	}
+
+	*out++ = buttons&0xFF;
+	*out++ = (buttons>>8)&0xFF;
+	*out++ = (buttons>>16)&0xFF;
+	*out++ = (buttons>>24)&0xFF;
+
+	BYTE ambuttons = 0;
+	for(unsigned int i = 0;i < NUMAMBUTTONS;++i)
+	{
+		if(cmd.ambuttonstate[i])
+			ambuttons |= 1u<<i;
+	}
+	*out++ = ambuttons;
+
+	WriteShort(out, cmd.controlx);
+	WriteShort(out, cmd.controly);
+	WriteShort(out, cmd.controlstrafe);
+	WriteShort(out, cmd.controlpanx);
+	WriteShort(out, cmd.controlpany);
+}
+
+static void UnpackTic(const BYTE *in, TicCmd_t &cmd)
+{
+	const DWORD buttons = in[0]|(in[1]<<8)|(in[2]<<16)|(in[3]<<24);
+	in += 4;
+	for(unsigned int i = 0;i < NUMBUTTONS;++i)
+		cmd.buttonstate[i] = (buttons>>i)&1;
+
+	const BYTE ambuttons = *in++;
+	for(unsigned int i = 0;i < NUMAMBUTTONS;++i)
+		cmd.ambuttonstate[i] = (ambuttons>>i)&1;
+
+	cmd.controlx = ReadShort(in);
+	cmd.controly = ReadShort(in);
+	cmd.controlstrafe = ReadShort(in);
+	cmd.controlpanx = ReadShort(in);
+	cmd.controlpany = ReadShort(in);
+}
+
+//==========================================================================
+
+FDemoWriter::FDemoWriter() : File(NULL), TicsSinceFlush(0)
+{
+	memset(&Stream, 0, sizeof(Stream));
+}
+
+FDemoWriter::~FDemoWriter()
+{
+	Close();
+}
+
+bool FDemoWriter::Open(const char* filename, const FString &map, int skill, DWORD seed)
+{
+	Close();
+
+	if(map.Len() > 255)
+		return false;
+
+	memset(&Stream, 0, sizeof(Stream));
+	if(deflateInit(&Stream, Z_BEST_COMPRESSION) != Z_OK)
+		return false;
+
+	if(!(File = fopen(filename, "wb")))
+	{
+		deflateEnd(&Stream);
+		return false;
+	}
+
+	BYTE header[11];
+	memcpy(header, DEMO_MAGIC, 4);
+	header[4] = DEMO_VERSION;
+	header[5] = static_cast<BYTE>(skill);
+	header[6] = seed&0xFF;
+	header[7] = (seed>>8)&0xFF;
+	header[8] = (seed>>16)&0xFF;
+	header[9] = (seed>>24)&0xFF;
+	header[10] = static_cast<BYTE>(map.Len());
+	fwrite(header, 1, sizeof(header), File);
+	fwrite(map.GetChars(), 1, map.Len(), File);
+
+	TicsSinceFlush = 0;
+	return true;
+}
+
+void FDemoWriter::Close()
+{
+	if(!File)
+		return;
+
+	Deflate(Z_FINISH);
+	deflateEnd(&Stream);
+	fclose(File);
+	File = NULL;
+}
+
+void FDemoWriter::WriteTic(const TicCmd_t &cmd)
+{
+	if(!File)
+		return;
+
+	BYTE tic[DEMO_TICSIZE];
+	PackTic(tic, cmd);
+
+	Stream.next_in = tic;
+	Stream.avail_in = DEMO_TICSIZE;
+	if(++TicsSinceFlush >= DEMO_FLUSHTICS)
+	{
+		Deflate(Z_SYNC_FLUSH);
+		fflush(File);
+		TicsSinceFlush = 0;
+	}
+	else
+		Deflate(Z_NO_FLUSH);
+}
+
+void FDemoWriter::Deflate(int flush)
+{
+	int err;
+	do
+	{
+		Stream.next_out = OutBuff;
+		Stream.avail_out = BUFF_SIZE;
+		err = deflate(&Stream, flush);
+		if(err == Z_STREAM_ERROR)
+			break;
+
+		fwrite(OutBuff, 1, BUFF_SIZE - Stream.avail_out, File);
+	}
+	while(flush == Z_FINISH ? err != Z_STREAM_END : Stream.avail_out == 0);
+}
+
+//==========================================================================
+
+FDemoReader::FDemoReader(FileReader &file) : File(file), Valid(false),
+	SawEOF(false), StreamEnded(false), Skill(0), Seed(0)
+{
+	memset(&Stream, 0, sizeof(Stream));
+
+	BYTE header[11];
+	if(File.Read(header, sizeof(header)) != sizeof(header) ||
+		memcmp(header, DEMO_MAGIC, 4) != 0 || header[4] != DEMO_VERSION)
+		return;
+
+	Skill = header[5];
+	Seed = header[6]|(header[7]<<8)|(header[8]<<16)|(header[9]<<24);
+
+	char map[256];
+	if(File.Read(map, header[10]) != header[10])
+		return;
+	Map = FString(map, header[10]);
+
+	if(inflateInit(&Stream) != Z_OK)
+		return;
+	Valid = true;
+}
+
+FDemoReader::~FDemoReader()
+{
+	if(Valid)
+		inflateEnd(&Stream);
+}
+
+// Checks for the extended demo signature without moving the file position.
+bool FDemoReader::Check(FileReader &file)
+{
+	char magic[4];
+	const long read = file.Read(magic, 4);
+	file.Seek(-read, SEEK_CUR);
+	return read == 4 && memcmp(magic, DEMO_MAGIC, 4) == 0;
+}
+
+// Returns false once the demo is over. A recording that was cut off will
+// end at the last complete tic.
+bool FDemoReader::ReadTic(TicCmd_t &cmd)
+{
+	if(!Valid || StreamEnded)
+		return false;
+
+	BYTE tic[DEMO_TICSIZE];
+	Stream.next_out = tic;
+	Stream.avail_out = DEMO_TICSIZE;
+
+	while(Stream.avail_out != 0)
+	{
+		if(Stream.avail_in == 0)
+		{
+			if(SawEOF)
+				return false;
+
+			const long numread = File.Read(InBuff, BUFF_SIZE);
+			if(numread < BUFF_SIZE)
+				SawEOF = true;
+			if(numread <= 0)
+				return false;
+
+			Stream.next_in = InBuff;
+			Stream.avail_in = numread;
+		}
+
+		const int err = inflate(&Stream, Z_NO_FLUSH);
+		if(err == Z_STREAM_END)
+		{
+			StreamEnded = true;
+			break;
+		}
+		else if(err != Z_OK)
+			return false;
+	}
+
+	if(Stream.avail_out != 0)
+		return false;
+
+	UnpackTic(tic, cmd);
+	return true;
+}
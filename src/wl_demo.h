@@ -0,0 +1,107 @@
+/*
+** wl_demo.h
+**
+**---------------------------------------------------------------------------
+** Copyright 2026 The ECWolf Team
+** All rights reserved.
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** Extended demo format. Unlike the original demos these have no length
+** limit and can start on any map. The file begins with an uncompressed
+** header and is followed by a zlib stream of tic commands which is written
+** out as the game is played.
+**
+*/
+
+#ifndef __WL_DEMO_H__
+#define __WL_DEMO_H__
+
+#include <stdio.h>
+#include <zlib.h>
+
+#include "wl_def.h"
+#include "zstring.h"
+
+class FileReader;
+struct TicCmd_t;
+
+#define DEMO_MAGIC "ECWD"
+#define DEMO_VERSION 2
+
+class FDemoWriter
+{
+public:
+	FDemoWriter();
+	~FDemoWriter();
+
+	bool Open(const char* filename, const FString &map, int skill, DWORD seed);
+	void Close();
+	bool IsOpen() const { return File != NULL; }
+	void WriteTic(const TicCmd_t &cmd);
+
+private:
+	enum { BUFF_SIZE = 4096 };
+
+	void Deflate(int flush);
+
+	FILE *File;
+	z_stream Stream;
+	unsigned int TicsSinceFlush;
+	BYTE OutBuff[BUFF_SIZE];
+};
+
+class FDemoReader
+{
+public:
+	FDemoReader(FileReader &file);
+	~FDemoReader();
+
+	static bool Check(FileReader &file);
+
+	bool IsValid() const { return Valid; }
+	const FString &GetMap() const { return Map; }
+	int GetSkill() const { return Skill; }
+	DWORD GetSeed() const { return Seed; }
+
+	bool ReadTic(TicCmd_t &cmd);
+
+private:
+	enum { BUFF_SIZE = 4096 };
+
+	FileReader &File;
+	z_stream Stream;
+	bool Valid;
+	bool SawEOF;
+	bool StreamEnded;
+	FString Map;
+	int Skill;
+	DWORD Seed;
+	BYTE InBuff[BUFF_SIZE];
+
+	FDemoReader &operator= (const FDemoReader &) { return *this; }
+};
+
+#endif
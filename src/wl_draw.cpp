@@ -8,8 +8,10 @@
 #include "id_us.h"
 #include "textures/textures.h"
 #include "c_cvars.h"
+#include "r_columntile.h"
 #include "r_sprites.h"
 #include "r_data/colormaps.h"
+#include "stats.h"
 
 #include "wl_cloudsky.h"
 #include "wl_atmos.h"
@@ -49,7 +51,7 @@
 =============================================================================
 */
 
-void DrawFloorAndCeiling(byte *vbuf, unsigned vbufPitch, int min_wallheight);
+bool DrawFloorAndCeiling(byte *vbuf, unsigned vbufPitch, int min_wallheight, const byte *columns);
 
 const RatioInformation AspectCorrection[] =
 {
@@ -90,6 +92,16 @@ angle_t viewangle;
 fixed   viewsin,viewcos;
 int viewshift = 0;
 fixed viewz = 32;
+fixed r_ticfrac = FRACUNIT;
+
+// Camera position before the most recent tic. Only compared against, the
+// actor may be gone by now.
+static struct
+{
+	const AActor *camera;
+	fixed x, y;
+	angle_t angle;
+} prevcam;
 
 fixed gLevelVisibility = VISIBILITY_DEFAULT;
 fixed gLevelMaxLightVis = MAXLIGHTVIS_DEFAULT;
@@ -112,6 +124,7 @@ int     lastside;               // true for vertical
 int32_t    lastintercept;
 MapSpot lasttilehit;
 int     lasttexture;
+static bool WallsWarped;        // a warped texture was drawn, can't be reused
 
 //
 // ray tracing variables
@@ -240,6 +253,106 @@ int CalcHeight()
 
 //==========================================================================
 
+/*
+===================
+=
+= Lighting tables
+=
+= Past some height the light is limited by gLevelMaxLightVis so every wall
+= nearer than that shares the last colormap in the table.
+=
+===================
+*/
+
+#define MAXDEPTHCOLORMAPS 8192
+
+static struct
+{
+	int shade;
+	fixed visibility;
+	fixed maxLightVis;
+	const BYTE *maps;
+	unsigned int serial;
+} LightKey;
+
+static const BYTE *DepthColormaps[MAXDEPTHCOLORMAPS];
+static int NumDepthColormaps = 0;
+static bool DepthSaturated = false;
+
+static struct FFlatColormaps
+{
+	unsigned int serial;
+	fixed planeheight;
+	TArray<const BYTE *> rows;
+} FlatColormaps[2];
+
+static inline const BYTE *R_CalcDepthColormap(int height)
+{
+	const int tz = FixedMul(r_depthvisibility<<8, height);
+	return &NormalLight.Maps[GETPALOOKUP(MAX(tz, MINZ), LightKey.shade)<<8];
+}
+
+void R_SetupLighting()
+{
+	const int shade = LIGHT2SHADE(gLevelLight + r_extralight);
+	if(LightKey.serial != 0 && LightKey.shade == shade && LightKey.visibility == r_depthvisibility &&
+		LightKey.maxLightVis == gLevelMaxLightVis && LightKey.maps == NormalLight.Maps)
+		return;
+
+	LightKey.shade = shade;
+	LightKey.visibility = r_depthvisibility;
+	LightKey.maxLightVis = gLevelMaxLightVis;
+	LightKey.maps = NormalLight.Maps;
+	++LightKey.serial;
+
+	NumDepthColormaps = 0;
+	DepthSaturated = false;
+	while(NumDepthColormaps < MAXDEPTHCOLORMAPS)
+	{
+		const int height = NumDepthColormaps;
+		DepthColormaps[NumDepthColormaps++] = R_CalcDepthColormap(height);
+		if(FixedMul(r_depthvisibility<<8, height) >= gLevelMaxLightVis)
+		{
+			DepthSaturated = true;
+			break;
+		}
+	}
+}
+
+const BYTE *R_DepthColormap(int height)
+{
+	if((unsigned)height < (unsigned)NumDepthColormaps)
+		return DepthColormaps[height];
+	if(height < 0)
+		return DepthColormaps[0];
+	if(DepthSaturated)
+		return DepthColormaps[NumDepthColormaps-1];
+	return R_CalcDepthColormap(height);
+}
+
+// Colormap for each row away from the horizon of a flat at planeheight.
+// Slots let the floor and ceiling keep their own table.
+const BYTE * const *R_FlatColormaps(unsigned int slot, fixed planeheight, unsigned int rows)
+{
+	FFlatColormaps &flat = FlatColormaps[slot];
+	if(flat.serial != LightKey.serial || flat.planeheight != planeheight || flat.rows.Size() < rows)
+	{
+		flat.serial = LightKey.serial;
+		flat.planeheight = planeheight;
+		flat.rows.Resize(MAX(rows, 1u));
+
+		const fixed depth = FixedDiv(r_depthvisibility, abs(planeheight));
+		for(unsigned int y = 0;y < flat.rows.Size();++y)
+		{
+			const int tz = FixedMul(depth, y<<FRACBITS);
+			flat.rows[y] = &NormalLight.Maps[GETPALOOKUP(tz, LightKey.shade)<<8];
+		}
+	}
+	return &flat.rows[0];
+}
+
+//==========================================================================
+
 /*
 ===================
 =
@@ -251,17 +364,98 @@ int CalcHeight()
 const byte *postsource;
 int postx;
 
+// Wall columns already translated through a light table. Neighbouring
+// screen columns usually land on the same texel column at the same light,
+// so close walls only translate each column once. Direct mapped with a
+// fixed footprint and flushed every frame since texture data can be
+// freed between frames.
+#define SHADECACHE_BITS 10
+#define SHADECACHE_SLOTS (1<<SHADECACHE_BITS)
+#define SHADECACHE_HEIGHT 256
+
+static struct ShadeCacheKey
+{
+	const byte *source;
+	const BYTE *shades;
+	unsigned int frame;
+} ShadeCacheKeys[SHADECACHE_SLOTS];
+static BYTE ShadeCacheData[SHADECACHE_SLOTS][SHADECACHE_HEIGHT];
+static unsigned int ShadeCacheFrame = 1;
+
+static const BYTE *GetShadedColumn(const byte *source, const BYTE *shades, int height)
+{
+	// Columns are a multiple of the texture height apart and light tables
+	// 256 bytes apart, so the low bits of either pointer say little. Mix
+	// the whole key and use the top bits.
+	const DWORD mix = DWORD(size_t(source)) ^ DWORD(size_t(shades))*0x85EBCA77u;
+	const unsigned int hash = DWORD(mix*0x9E3779B1u) >> (32-SHADECACHE_BITS);
+
+	ShadeCacheKey &key = ShadeCacheKeys[hash];
+	BYTE *data = ShadeCacheData[hash];
+	if(key.frame == ShadeCacheFrame && key.source == source && key.shades == shades)
+		return data;
+
+	key.source = source;
+	key.shades = shades;
+	key.frame = ShadeCacheFrame;
+	for(int i = 0;i < height;++i)
+		data[i] = shades[source[i]];
+	return data;
+}
+
+// Texel fetches for ScalePost, either translating on the fly or from a
+// shaded column.
+struct FShadeTexel
+{
+	const byte *source;
+	const BYTE *shades;
+	byte operator[](int i) const { return shades[source[i]]; }
+};
+struct FShadedTexel
+{
+	const BYTE *column;
+	byte operator[](int i) const { return column[i]; }
+};
+
+// Posts are gathered into a tile four columns wide which is written to
+// the screen a row at a time.
+static FColumnTile WallTile;
+
+// Draws the post from row bottom up to row top into the wall tile. Returns
+// the last row drawn, which is below top if the texture ran out first.
+template<class Texel>
+static int DrawPost(const Texel &texel, int yw, int ywcount, int yd, int top, int bottom)
+{
+	BYTE *dest = WallTile.Column(postx) + bottom*FColumnTile::WIDTH;
+	byte col = texel[yw];
+	int y;
+	for(y = bottom;y >= top;--y, dest -= FColumnTile::WIDTH)
+	{
+		*dest = col;
+		ywcount -= texyscale/2;
+		if(ywcount <= 0)
+		{
+			do
+			{
+				ywcount += yd;
+				yw--;
+			}
+			while(ywcount <= 0);
+			if(yw < 0) return y;
+			col = texel[yw];
+		}
+	}
+	return y+1;
+}
+
 void ScalePost()
 {
 	if(postsource == NULL)
 		return;
 
-	int ywcount, yoffs, yw, yd, yendoffs;
-	byte col;
+	int ywcount, ytop, yw, yd, yend;
 
-	const int shade = LIGHT2SHADE(gLevelLight + r_extralight);
-	const int tz = FixedMul(r_depthvisibility<<8, wallheight[postx]);
-	BYTE *curshades = &NormalLight.Maps[GETPALOOKUP(MAX(tz, MINZ), shade)<<8];
+	const BYTE *curshades = R_DepthColormap(wallheight[postx]);
 
 	ywcount = yd = (wallheight[postx] >> 3);
 	if(yd <= 0)
@@ -274,15 +468,14 @@ void ScalePost()
 		const int topoffset = ywcount*(viewz>>8)/(32<<(FRACBITS-8));
 		const int botoffset = ywcount*((viewz - (64<<FRACBITS))>>8)/(32<<(FRACBITS-8));
 
-		yoffs = (viewheight / 2 - topoffset - viewshift) * vbufPitch;
-		if(yoffs < 0) yoffs = 0;
-		yoffs += postx;
+		ytop = viewheight / 2 - topoffset - viewshift;
+		if(ytop < 0) ytop = 0;
 
-		yendoffs = viewheight / 2 - botoffset - 1 - viewshift;
+		yend = viewheight / 2 - botoffset - 1 - viewshift;
 		yw=texyscale-1;
 	}
 
-	while(yendoffs >= viewheight)
+	while(yend >= viewheight)
 	{
 		ywcount -= texyscale/2;
 		while(ywcount <= 0)
@@ -290,37 +483,33 @@ void ScalePost()
 			ywcount += yd;
 			yw--;
 		}
-		yendoffs--;
+		yend--;
 	}
 	if(yw < 0)
 		return;
 
-	col = curshades[postsource[yw]];
-	yendoffs = yendoffs * vbufPitch + postx;
-	while(yoffs <= yendoffs)
+	// Only worth shading the whole column when each texel covers at least
+	// a pixel. Further away most texels are skipped.
+	if(yd >= texyscale/2 && texyscale <= SHADECACHE_HEIGHT)
 	{
-		vbuf[yendoffs] = col;
-		ywcount -= texyscale/2;
-		if(ywcount <= 0)
-		{
-			do
-			{
-				ywcount += yd;
-				yw--;
-			}
-			while(ywcount <= 0);
-			if(yw < 0) break;
-			col = curshades[postsource[yw]];
-		}
-		yendoffs -= vbufPitch;
+		const FShadedTexel texel = { GetShadedColumn(postsource, curshades, texyscale) };
+		ytop = DrawPost(texel, yw, ywcount, yd, ytop, yend);
+	}
+	else
+	{
+		const FShadeTexel texel = { postsource, curshades };
+		ytop = DrawPost(texel, yw, ywcount, yd, ytop, yend);
 	}
+	WallTile.AddSpan(postx, ytop, yend);
 }
 
 void GlobalScalePost(byte *vidbuf, unsigned pitch)
 {
 	vbuf = vidbuf;
 	vbufPitch = pitch;
+	WallTile.Begin(vbuf, vbufPitch, viewwidth, viewheight);
 	ScalePost();
+	WallTile.Flush();
 }
 
 static void DetermineHitDir(bool vertical)
@@ -423,6 +612,8 @@ void HitVertWall (void)
 		texture -= texture%texxscale;
 
 		postsource = source->GetColumn(texture/texxscale, NULL);
+		if(source->bWarped)
+			WallsWarped = true;
 	}
 	else
 		postsource = NULL;
@@ -497,6 +688,8 @@ void HitHorizWall (void)
 		texture -= texture%texxscale;
 
 		postsource = source->GetColumn(texture/texxscale, NULL);
+		if(source->bWarped)
+			WallsWarped = true;
 	}
 	else
 		postsource = NULL;
@@ -526,7 +719,7 @@ unsigned int CalcRotate (AActor *ob)
 	// this isn't exactly correct, as it should vary by a trig value,
 	// but it is close enough with only eight rotations
 
-	viewangle = players[ConsolePlayer].camera->angle + (centerx - ob->viewx)/8;
+	viewangle = ::viewangle + (centerx - ob->viewx)/8;
 
 	angle = viewangle - ob->angle;
 
@@ -710,12 +903,59 @@ void CalcTics (void)
 
 	if (tics>MAXTICS)
 		tics = MAXTICS;
+
+	r_ticfrac = FRACUNIT;
+}
+
+/*
+=====================
+=
+= CalcFrameTics
+=
+= Like CalcTics but returns right away with no tics when the next one isn't
+= due yet so a frame can be drawn in between. The view is interpolated by
+= how far we are into the current tic.
+=
+=====================
+*/
+
+void CalcFrameTics (void)
+{
+	if (lasttimecount > (int32_t) GetTimeCount())
+		lasttimecount = GetTimeCount();    // if the game was paused a LONG time
+
+	uint32_t curtime = SDL_GetTicks();
+	tics = (curtime * 7) / 100 - lasttimecount;
+	lasttimecount += tics;
+
+	if (tics>MAXTICS)
+	{
+		tics = MAXTICS;
+		r_ticfrac = FRACUNIT;
+	}
+	else
+		r_ticfrac = (((curtime * 7) % 100) << FRACBITS) / 100;
+}
+
+void R_SaveCameraPosition (void)
+{
+	const AActor *camera = players[ConsolePlayer].camera;
+	if(camera == NULL)
+		camera = players[ConsolePlayer].mo;
+
+	prevcam.camera = camera;
+	if(camera)
+	{
+		prevcam.x = camera->x;
+		prevcam.y = camera->y;
+		prevcam.angle = camera->angle;
+	}
 }
 
 
 //==========================================================================
 
-void AsmRefresh()
+void AsmRefresh(int startx, int stopx)
 {
 	static word xspot[2],yspot[2];
 	int32_t xstep=0,ystep=0;
@@ -723,7 +963,7 @@ void AsmRefresh()
 	MapSpot focalspot = map->GetSpot(focaltx, focalty, 0);
 	bool playerInPushwallBackTile = focalspot->pushAmount != 0;
 
-	for(pixx=0;pixx<viewwidth;pixx++)
+	for(pixx=startx;pixx<stopx;pixx++)
 	{
 		short angl=midangle+pixelangle[pixx];
 		if(angl<0) angl+=FINEANGLES;
@@ -1159,42 +1399,344 @@ passhoriz:
 ====================
 */
 
-void WallRefresh (void)
+// Casts the columns set in columns, or every column if it is NULL.
+void WallRefresh (const byte *columns)
 {
 	xpartialdown = viewx&(TILEGLOBAL-1);
 	xpartialup = TILEGLOBAL-xpartialdown;
 	ypartialdown = viewy&(TILEGLOBAL-1);
 	ypartialup = TILEGLOBAL-ypartialdown;
 
+	WallsWarped = false;
+	++ShadeCacheFrame;
+	WallTile.Begin(vbuf, vbufPitch, viewwidth, viewheight);
+
+	if(columns == NULL)
+	{
+		min_wallheight = viewheight;
+		lastside = -1;                  // the first pixel is on a new wall
+		AsmRefresh(0, viewwidth);
+		ScalePost ();                   // no more optimization on last post
+		WallTile.Flush();
+		return;
+	}
+
+	for(int startx = 0;startx < viewwidth;)
+	{
+		if(!columns[startx])
+		{
+			++startx;
+			continue;
+		}
+
+		int stopx = startx+1;
+		while(stopx < viewwidth && columns[stopx])
+			++stopx;
+
+		lastside = -1;
+		AsmRefresh(startx, stopx);
+		if(lastside != -1)
+			ScalePost ();
+		startx = stopx;
+	}
+	WallTile.Flush();
+
 	min_wallheight = viewheight;
-	lastside = -1;                  // the first pixel is on a new wall
-	viewshift = FixedMul(focallengthy, finetangent[(ANGLE_180+players[ConsolePlayer].camera->pitch)>>ANGLETOFINESHIFT]);
+	for(int x = 0;x < viewwidth;++x)
+	{
+		if(wallheight[x] < min_wallheight)
+			min_wallheight = wallheight[x];
+	}
+}
 
-	
-	angle_t bobangle = ((gamestate.TimeCount<<13)/(20*TICRATE/35)) & FINEMASK;
-	const fixed playerMovebob = players[ConsolePlayer].mo->GetClass()->Meta.GetMetaFixed(APMETA_MoveBob);
-	fixed curbob = gamestate.victoryflag ? 0 : FixedMul(FixedMul(players[ConsolePlayer].bob, playerMovebob)>>1, finesine[bobangle]);
+/*
+====================
+=
+= Frame coherence
+=
+= When the view hasn't moved since the last frame, the walls, floor and
+= ceiling are copied back from it and only the columns which can see a map
+= spot that changed are cast again. Every spot a ray could have touched is
+= recorded, so doors, pushwalls and switches are noticed without the game
+= code having to report them.
+=
+====================
+*/
 
-	viewz = (64<<FRACBITS) - players[ConsolePlayer].mo->viewheight + curbob;
+struct FrameKey
+{
+	const GameMap *map;
+	unsigned int width, height;
+	fixed x, y, z;
+	angle_t angle;
+	int shift;
+	int viewwidth, viewheight;
+	unsigned pitch;
+	fixed scale;
+	int32_t heightnumerator;
+	int light;
+	fixed visibility;
+	const BYTE *colormaps;
+	unsigned int animserial;
+};
+
+struct FSpotState
+{
+	unsigned int x, y;
+	const MapTile *tile;
+	const MapSector *sector;
+	FTextureID texture[4];
+	unsigned int slideAmount[4];
+	unsigned int pushAmount;
+	MapSpot pushReceptor;
+	unsigned int receptorAmount;
+
+	void Read(unsigned int x, unsigned int y)
+	{
+		const MapSpot spot = map->GetSpot(x, y, 0);
+		this->x = x;
+		this->y = y;
+		tile = spot->tile;
+		sector = spot->sector;
+		for(unsigned int i = 0;i < 4;++i)
+		{
+			texture[i] = spot->texture[i];
+			slideAmount[i] = spot->slideAmount[i];
+		}
+		pushAmount = spot->pushAmount;
+		pushReceptor = spot->pushReceptor;
+		receptorAmount = pushReceptor ? pushReceptor->pushAmount : 0;
+	}
+
+	bool operator!=(const FSpotState &other) const
+	{
+		if(tile != other.tile || sector != other.sector || pushAmount != other.pushAmount ||
+			pushReceptor != other.pushReceptor || receptorAmount != other.receptorAmount)
+			return true;
+		for(unsigned int i = 0;i < 4;++i)
+		{
+			if(texture[i] != other.texture[i] || slideAmount[i] != other.slideAmount[i])
+				return true;
+		}
+		return false;
+	}
+};
+
+static bool CoherentValid = false;
+static FrameKey CoherentKey;
+static int CoherentMinWallHeight;
+static TArray<byte> CoherentPixels;
+static TArray<FSpotState> CoherentSpots;
+static TArray<byte> DirtyColumns;
+
+static bool R_SkyActive()
+{
+#if defined(USE_FEATUREFLAGS)
+	return (GetFeatureFlags() & (FF_STARSKY|FF_PARALLAXSKY|FF_CLOUDSKY)) != 0;
+#else
+	return false;
+#endif
+}
+
+static void R_GetFrameKey(FrameKey &key)
+{
+	// Zeroed so that padding doesn't upset the memcmp.
+	memset(&key, 0, sizeof(key));
+	key.map = map;
+	key.width = mapwidth;
+	key.height = mapheight;
+	key.x = viewx;
+	key.y = viewy;
+	key.z = viewz;
+	key.angle = viewangle;
+	key.shift = viewshift;
+	key.viewwidth = viewwidth;
+	key.viewheight = viewheight;
+	key.pitch = vbufPitch;
+	key.scale = scale;
+	key.heightnumerator = heightnumerator;
+	key.light = gLevelLight + r_extralight;
+	key.visibility = r_depthvisibility;
+	key.colormaps = NormalLight.Maps;
+	key.animserial = TexMan.GetAnimationSerial();
+}
+
+// Marks the columns which could see into the given rectangle of the map.
+// Columns whose wall is nearer than any part of the rectangle are left
+// alone since the ray never got that far. Returns the number of columns
+// newly marked.
+static int R_MarkColumns(fixed left, fixed top, fixed right, fixed bottom)
+{
+	const fixed cornerx[4] = { left, right, left, right };
+	const fixed cornery[4] = { top, top, bottom, bottom };
+
+	int x1 = viewwidth, x2 = -1;
+	fixed nearest = 0x7FFFFFFF;
+	bool behind = false;
+	for(unsigned int i = 0;i < 4;++i)
+	{
+		const fixed gx = cornerx[i]-viewx;
+		const fixed gy = cornery[i]-viewy;
+		const fixed nx = FixedMul(gx,viewcos)-FixedMul(gy,viewsin);
+		const fixed ny = FixedMul(gx,viewsin)+FixedMul(gy,viewcos);
+
+		if(nx < nearest)
+			nearest = nx;
+		if(nx < MINDIST)
+		{
+			behind = true;
+			continue;
+		}
+
+		const int sx = centerx + int((SQWORD)ny*scale/nx);
+		if(sx < x1) x1 = sx;
+		if(sx > x2) x2 = sx;
+	}
 
-	AsmRefresh();
-	ScalePost ();                   // no more optimization on last post
+	int height;
+	if(behind)
+	{
+		// Crosses the view plane so it could be anywhere on screen.
+		x1 = 0;
+		x2 = viewwidth-1;
+		height = 0x7FFFFFFF;
+	}
+	else
+	{
+		// Rays are cast at slightly different angles than the projection
+		// above, so give both a little slack.
+		x1 = MAX(x1-2, 0);
+		x2 = MIN(x2+2, viewwidth-1);
+		height = (heightnumerator<<8)/MAX<fixed>(nearest-0x100, MINDIST);
+	}
+
+	int marked = 0;
+	for(int x = x1;x <= x2;++x)
+	{
+		if(!DirtyColumns[x] && wallheight[x] <= height)
+		{
+			DirtyColumns[x] = 1;
+			++marked;
+		}
+	}
+	return marked;
+}
+
+// Copies the last frame back if it can be reused and marks the columns
+// which need to be drawn again. Returns the number of marked columns or -1
+// if the whole view needs to be drawn.
+static int R_RestoreCoherentFrame()
+{
+	if(!vid_framecoherence || R_SkyActive())
+	{
+		CoherentValid = false;
+		return -1;
+	}
+
+	FrameKey key;
+	R_GetFrameKey(key);
+	if(!CoherentValid || memcmp(&key, &CoherentKey, sizeof(key)) != 0)
+		return -1;
+
+	for(int y = 0;y < viewheight;++y)
+		memcpy(vbuf + y*vbufPitch, &CoherentPixels[y*viewwidth], viewwidth);
+	min_wallheight = CoherentMinWallHeight;
+
+	memset(&DirtyColumns[0], 0, viewwidth);
+	int dirty = 0;
+	for(unsigned int i = 0;i < CoherentSpots.Size();++i)
+	{
+		const FSpotState &last = CoherentSpots[i];
+		FSpotState now;
+		now.Read(last.x, last.y);
+		if(now != last)
+		{
+			// Pushwalls span into the neighbouring spots as they move.
+			const fixed extend = (last.pushAmount || last.pushReceptor || now.pushAmount || now.pushReceptor) ? TILEGLOBAL : 0;
+			const fixed left = fixed(last.x<<TILESHIFT), top = fixed(last.y<<TILESHIFT);
+			dirty += R_MarkColumns(left-extend, top-extend, left+TILEGLOBAL+extend, top+TILEGLOBAL+extend);
+		}
+	}
+	return dirty;
+}
+
+// Keeps the walls, floor and ceiling which were just drawn along with the
+// state of every spot near the ones the rays passed through.
+static void R_SaveCoherentFrame(bool warpedFlats)
+{
+	if(warpedFlats || WallsWarped || R_SkyActive())
+	{
+		CoherentValid = false;
+		return;
+	}
+
+	R_GetFrameKey(CoherentKey);
+	CoherentMinWallHeight = min_wallheight;
+
+	CoherentPixels.Resize(viewwidth*viewheight);
+	for(int y = 0;y < viewheight;++y)
+		memcpy(&CoherentPixels[y*viewwidth], vbuf + y*vbufPitch, viewwidth);
+	DirtyColumns.Resize(viewwidth);
+
+	// Rays only mark the spots they pass through, the wall they hit is a
+	// neighbour of one of those or of the spot the view starts in.
+	const MapSpot focalspot = map->GetSpot(focaltx, focalty, 0);
+	CoherentSpots.Clear();
+	for(unsigned int y = 0;y < mapheight;++y)
+	{
+		for(unsigned int x = 0;x < mapwidth;++x)
+		{
+			const MapSpot spot = map->GetSpot(x, y, 0);
+			bool seen = spot->visible || spot == focalspot;
+			for(unsigned int dir = 0;!seen && dir < 4;++dir)
+			{
+				const MapSpot adj = spot->GetAdjacent(MapTile::Side(dir));
+				seen = adj && (adj->visible || adj == focalspot);
+			}
+
+			if(seen)
+				CoherentSpots[CoherentSpots.Reserve(1)].Read(x, y);
+		}
+	}
+	CoherentValid = true;
 }
 
 void CalcViewVariables()
 {
-	viewangle = players[ConsolePlayer].camera->angle;
+	const AActor *camera = players[ConsolePlayer].camera;
+	fixed camx = camera->x;
+	fixed camy = camera->y;
+	viewangle = camera->angle;
+
+	// Blend from where the camera was before the last tic. Anything which
+	// moved more than a tile was a teleport and shouldn't be smeared.
+	if(r_ticfrac < FRACUNIT && prevcam.camera == camera &&
+		abs(camx - prevcam.x) < TILEGLOBAL && abs(camy - prevcam.y) < TILEGLOBAL)
+	{
+		camx = prevcam.x + FixedMul(camx - prevcam.x, r_ticfrac);
+		camy = prevcam.y + FixedMul(camy - prevcam.y, r_ticfrac);
+		viewangle = prevcam.angle + FixedMul(int32_t(viewangle - prevcam.angle), r_ticfrac);
+	}
+
 	midangle = viewangle>>ANGLETOFINESHIFT;
 	viewsin = finesine[viewangle>>ANGLETOFINESHIFT];
 	viewcos = finecosine[viewangle>>ANGLETOFINESHIFT];
-	viewx = players[ConsolePlayer].camera->x - FixedMul(focallength,viewcos);
-	viewy = players[ConsolePlayer].camera->y + FixedMul(focallength,viewsin);
+	viewx = camx - FixedMul(focallength,viewcos);
+	viewy = camy + FixedMul(focallength,viewsin);
 
 	focaltx = (short)(viewx>>TILESHIFT);
 	focalty = (short)(viewy>>TILESHIFT);
 
-	viewtx = (short)(players[ConsolePlayer].camera->x >> TILESHIFT);
-	viewty = (short)(players[ConsolePlayer].camera->y >> TILESHIFT);
+	viewtx = (short)(camx >> TILESHIFT);
+	viewty = (short)(camy >> TILESHIFT);
+
+	viewshift = FixedMul(focallengthy, finetangent[(ANGLE_180+camera->pitch)>>ANGLETOFINESHIFT]);
+
+	angle_t bobangle = ((gamestate.TimeCount<<13)/(20*TICRATE/35)) & FINEMASK;
+	const fixed playerMovebob = players[ConsolePlayer].mo->GetClass()->Meta.GetMetaFixed(APMETA_MoveBob);
+	fixed curbob = gamestate.victoryflag ? 0 : FixedMul(FixedMul(players[ConsolePlayer].bob, playerMovebob)>>1, finesine[bobangle]);
+
+	viewz = (64<<FRACBITS) - players[ConsolePlayer].mo->viewheight + curbob;
 
 	if(players[ConsolePlayer].camera->player)
 		r_extralight = players[ConsolePlayer].camera->player->extralight << 3;
@@ -1207,31 +1749,62 @@ void CalcViewVariables()
 void R_RenderView()
 {
 	CalcViewVariables();
+	R_SetupLighting();
+
+	// Number of columns to draw again, or -1 to draw everything.
+	const int dirtyColumns = R_RestoreCoherentFrame();
+	if(dirtyColumns < 0)
+		map->ClearVisibility();
 
 //
 // follow the walls from there to the right, drawing as we go
 //
 #if defined(USE_FEATUREFLAGS) && defined(USE_STARSKY)
 	if(GetFeatureFlags() & FF_STARSKY)
+	{
+		FProfileScope profile(PROF_Skies);
 		DrawStarSky(vbuf, vbufPitch);
+	}
 #endif
 
-	WallRefresh ();
+	{
+		FProfileScope profile(PROF_Walls);
+		if(dirtyColumns < 0)
+			WallRefresh (NULL);
+		else if(dirtyColumns > 0)
+			WallRefresh (&DirtyColumns[0]);
+	}
 
 #if defined(USE_FEATUREFLAGS) && defined(USE_PARALLAX)
 	if(GetFeatureFlags() & FF_PARALLAXSKY)
+	{
+		FProfileScope profile(PROF_Skies);
 		DrawParallax(vbuf, vbufPitch);
+	}
 #endif
 #if defined(USE_FEATUREFLAGS) && defined(USE_CLOUDSKY)
 	if(GetFeatureFlags() & FF_CLOUDSKY)
+	{
+		FProfileScope profile(PROF_Skies);
 		DrawClouds(vbuf, vbufPitch, min_wallheight);
+	}
 #endif
-	DrawFloorAndCeiling(vbuf, vbufPitch, min_wallheight);
+	if(dirtyColumns != 0)
+	{
+		FProfileScope profile(PROF_Floors);
+		const bool warpedFlats = DrawFloorAndCeiling(vbuf, vbufPitch, min_wallheight,
+			dirtyColumns < 0 ? NULL : &DirtyColumns[0]);
+		if(vid_framecoherence)
+			R_SaveCoherentFrame(warpedFlats);
+	}
 
 //
 // draw all the scaled images
 //
-	DrawScaleds();                  // draw scaled stuff
+	{
+		FProfileScope profile(PROF_Sprites);
+		DrawScaleds();                  // draw scaled stuff
+	}
 
 #if defined(USE_FEATUREFLAGS) && defined(USE_RAIN)
 	if(GetFeatureFlags() & FF_RAIN)
@@ -1242,10 +1815,14 @@ void R_RenderView()
 		DrawSnow(vbuf, vbufPitch);
 #endif
 
-	DrawPlayerWeapon ();    // draw player's hands
+	{
+		FProfileScope profile(PROF_Weapon);
+		DrawPlayerWeapon ();    // draw player's hands
+	}
 
 	if((control[ConsolePlayer].buttonstate[bt_showstatusbar] || control[ConsolePlayer].buttonheld[bt_showstatusbar]) && viewsize == 21)
 	{
+		FProfileScope profile(PROF_StatusBar);
 		ingame = false;
 		StatusBar->DrawStatusBar();
 		ingame = true;
@@ -1272,11 +1849,6 @@ void    ThreeDRefresh (void)
 	if (fizzlein && gameinfo.DeathTransition == GameInfo::TRANSITION_Fizzle)
 		FizzleFadeStart();
 
-//
-// clear out the traced array
-//
-	map->ClearVisibility();
-
 	vbuf = VL_LockSurface();
 	if(vbuf == NULL) return;
 
@@ -1301,22 +1873,27 @@ void    ThreeDRefresh (void)
 
 		lasttimecount = GetTimeCount();          // don't make a big tic count
 	}
-	else if (fpscounter)
+	else
 	{
-		FString fpsDisplay;
-		fpsDisplay.Format("%2u fps", fps);
-
-		word x = 0;
-		word y = 0;
-		word width, height;
-		VW_MeasurePropString(ConFont, fpsDisplay, width, height);
-		MenuToRealCoords(x, y, width, height, MENU_TOP);
-		VWB_Clear(GPalette.BlackIndex, x, y, x+width+1, y+height+1);
-		px = 0;
-		py = 0;
-		pa = MENU_TOP;
-		VWB_DrawPropString(ConFont, fpsDisplay, CR_WHITE);
-		pa = MENU_CENTER;
+		if (fpscounter)
+		{
+			FString fpsDisplay;
+			fpsDisplay.Format("%2u fps", fps);
+
+			word x = 0;
+			word y = 0;
+			word width, height;
+			VW_MeasurePropString(ConFont, fpsDisplay, width, height);
+			MenuToRealCoords(x, y, width, height, MENU_TOP);
+			VWB_Clear(GPalette.BlackIndex, x, y, x+width+1, y+height+1);
+			px = 0;
+			py = 0;
+			pa = MENU_TOP;
+			VWB_DrawPropString(ConFont, fpsDisplay, CR_WHITE);
+			pa = MENU_CENTER;
+		}
+
+		Profiler::DrawOverlay();
 	}
 
 	if (fpscounter)
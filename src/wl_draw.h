@@ -31,8 +31,14 @@ extern  bool fizzlein, fpscounter;
 extern  fixed   viewx,viewy;                    // the focal point
 extern  fixed   viewsin,viewcos;
 
+// Fraction of the way from the previous tic to the current one at which
+// the view is drawn. FRACUNIT when not interpolating.
+extern  fixed   r_ticfrac;
+
 void    ThreeDRefresh (void);
 void    CalcTics (void);
+void    CalcFrameTics (void);
+void    R_SaveCameraPosition (void);
 
 typedef struct
 {
@@ -13,22 +13,96 @@
 extern fixed viewshift;
 extern fixed viewz;
 
-static void R_DrawPlane(byte *vbuf, unsigned vbufPitch, int min_wallheight, int halfheight, fixed planeheight)
+// Texture state while walking a row of a flat. Cells are resolved in the
+// same order as the pixels so the result matches drawing them one by one.
+struct FFlatState
+{
+	const byte *tex;
+	int texwidth, texheight;
+	fixed texxscale, texyscale;
+	bool useOptimized;
+
+	bool SameDrawing(const FFlatState &other) const
+	{
+		return tex == other.tex && texwidth == other.texwidth && texheight == other.texheight &&
+			texxscale == other.texxscale && texyscale == other.texyscale && useOptimized == other.useOptimized;
+	}
+};
+
+// Number of steps until a global texture coordinate moves into another
+// map cell. The coordinates wrap like the per pixel sums did, so this
+// works on the raw bits.
+static inline unsigned int R_StepsToNextCell(fixed g, fixed d)
+{
+	const DWORD frac = DWORD(g) & ((1u<<(TILESHIFT+8))-1);
+	if(d > 0)
+		return ((1u<<(TILESHIFT+8)) - frac + DWORD(d) - 1)/DWORD(d);
+	if(d < 0)
+		return frac/DWORD(-SQWORD(d)) + 1;
+	return UINT_MAX;
+}
+
+static void R_DrawFlatRun64(byte *dest, const byte *tex, const byte *shades, fixed gu, fixed gv, fixed du, fixed dv, unsigned int count)
+{
+	for(;count;--count)
+	{
+		const int u = (gu>>18) & 63;
+		const int v = (-gv>>18) & 63;
+		*dest++ = shades[tex[(u * 64) + v]];
+		gu += du;
+		gv += dv;
+	}
+}
+
+static void R_DrawFlatRunScaled(byte *dest, const FFlatState &state, const byte *shades, fixed gu, fixed gv, fixed du, fixed dv, unsigned int count)
+{
+	const int umask = state.texwidth-1;
+	const int vmask = state.texheight-1;
+	for(;count;--count)
+	{
+		const int u = (FixedMul((gu>>8)-512, state.texxscale)) & umask;
+		const int v = (FixedMul((gv>>8)+512, state.texyscale)) & vmask;
+		*dest++ = shades[state.tex[(u * state.texheight) + v]];
+		gu += du;
+		gv += dv;
+	}
+}
+
+// Draws pixels [x1, x2) of a row whose leftmost pixel has the global
+// texture coordinates gu and gv.
+static void R_DrawFlatSpan(byte *row, const FFlatState &state, const byte *shades, fixed gu, fixed gv, fixed du, fixed dv, int x1, int x2)
+{
+	if(!state.tex || x2 <= x1)
+		return;
+
+	gu = fixed(DWORD(gu) + DWORD(x1)*DWORD(du));
+	gv = fixed(DWORD(gv) + DWORD(x1)*DWORD(dv));
+	if(state.useOptimized)
+		R_DrawFlatRun64(row + x1, state.tex, shades, gu, gv, du, dv, x2 - x1);
+	else
+		R_DrawFlatRunScaled(row + x1, state, shades, gu, gv, du, dv, x2 - x1);
+}
+
+// Only columns set in columns are drawn, or all of them if it is NULL.
+// Returns true if a warped flat was drawn.
+//
+// Each row is split into runs of visible pixels, which are walked a map
+// cell at a time. Neighbouring cells with the same flat are drawn in one
+// go so the map is only consulted when a cell boundary is crossed.
+static bool R_DrawPlane(byte *vbuf, unsigned vbufPitch, int min_wallheight, int halfheight, fixed planeheight, const byte *columns)
 {
 	fixed dist;                                // distance to row projection
 	fixed tex_step;                            // global step per one screen pixel
 	fixed gu, gv, du, dv;                      // global texture coordinates
-	const byte *tex = NULL;
-	int texwidth, texheight;
-	fixed texxscale, texyscale;
+	FFlatState state = { NULL, 0, 0, 0, 0, false };
 	FTextureID lasttex;
 	byte *tex_offset;
-	bool useOptimized = false;
+	bool warped = false;
 
 	const fixed heightFactor = abs(planeheight/32);
 	int y0 = (((min_wallheight >> 3)*heightFactor)>>FRACBITS) - abs(viewshift);
 	if(y0 > halfheight)
-		return; // view obscured by walls
+		return false; // view obscured by walls
 	if(y0 <= 0) y0 = 1; // don't let division by zero
 
 	lasttex.SetInvalid();
@@ -42,25 +116,30 @@ static void R_DrawPlane(byte *vbuf, unsigned vbufPitch, int min_wallheight, int
 	if(floor)
 	{
 		tex_offset = vbuf + (signed)vbufPitch * (halfheight + y0);
-		tex_offsetPitch = vbufPitch-viewwidth;
+		tex_offsetPitch = vbufPitch;
 		planenumerator *= -1;
 	}
 	else
 	{
 		tex_offset = vbuf + (signed)vbufPitch * (halfheight - y0 - 1);
-		tex_offsetPitch = -viewwidth-vbufPitch;
+		tex_offsetPitch = -(signed)vbufPitch;
 	}
 
+	// First row of each column which isn't behind a wall.
+	static TArray<int> openRow;
+	openRow.Resize(viewwidth);
+	for(int x = 0;x < viewwidth;++x)
+		openRow[x] = (!columns || columns[x]) ? ((wallheight[x] >> 3)*heightFactor)>>FRACBITS : INT_MAX;
+
 	unsigned int oldmapx = INT_MAX, oldmapy = INT_MAX;
 	const byte* curshades = NormalLight.Maps;
+	const int rows = floor ? viewheight-halfheight : halfheight;
+	const BYTE * const *rowshades = R_FlatColormaps(floor ? 0 : 1, planeheight, MAX(rows, 0));
 	// draw horizontal lines
 	for(int y = y0;floor ? y+halfheight < viewheight : y < halfheight; ++y, tex_offset += tex_offsetPitch)
 	{
 		if(floor ? (y+halfheight < 0) : (y < halfheight - viewheight))
-		{
-			tex_offset += viewwidth;
 			continue;
-		}
 
 		// Shift in some extra bits so that we don't get spectacular round off.
 		dist = (planenumerator / (y + 1))<<8;
@@ -73,16 +152,29 @@ static void R_DrawPlane(byte *vbuf, unsigned vbufPitch, int min_wallheight, int
 		gv -= (viewwidth >> 1) * dv; // starting point (leftmost)
 
 		// Depth fog
-		const int shade = LIGHT2SHADE(gLevelLight + r_extralight);
-		const int tz = FixedMul(FixedDiv(r_depthvisibility, abs(planeheight)), abs(((halfheight)<<16) - ((halfheight-y)<<16)));
-		curshades = &NormalLight.Maps[GETPALOOKUP(tz, shade)<<8];
+		curshades = rowshades[y];
 
-		for(unsigned int x = 0;x < (unsigned)viewwidth; ++x, ++tex_offset)
+		for(int runstart = 0;runstart < viewwidth;)
 		{
-			if(((wallheight[x] >> 3)*heightFactor)>>FRACBITS <= y)
+			if(openRow[runstart] > y)
 			{
-				unsigned int curx = (gu >> (TILESHIFT+8));
-				unsigned int cury = (-(gv >> (TILESHIFT+8)) - 1);
+				++runstart;
+				continue;
+			}
+			int runend = runstart+1;
+			while(runend < viewwidth && openRow[runend] <= y)
+				++runend;
+
+			// Walk the cells under [runstart, runend), drawing whenever the
+			// flat changes.
+			FFlatState drawing = state;
+			int drawstart = runstart;
+			for(int x = runstart;;)
+			{
+				const fixed cu = fixed(DWORD(gu) + DWORD(x)*DWORD(du));
+				const fixed cv = fixed(DWORD(gv) + DWORD(x)*DWORD(dv));
+				const unsigned int curx = (cu >> (TILESHIFT+8));
+				const unsigned int cury = (-(cv >> (TILESHIFT+8)) - 1);
 
 				if(curx != oldmapx || cury != oldmapy)
 				{
@@ -97,50 +189,49 @@ static void R_DrawPlane(byte *vbuf, unsigned vbufPitch, int min_wallheight, int
 						{
 							FTexture * const texture = TexMan(curtex);
 							lasttex = curtex;
-							tex = texture->GetPixels();
-							texwidth = texture->GetWidth();
-							texheight = texture->GetHeight();
-							texxscale = texture->xScale>>10;
-							texyscale = -texture->yScale>>10;
-
-							useOptimized = texwidth == 64 && texheight == 64 && texxscale == FRACUNIT>>10 && texyscale == -FRACUNIT>>10;
+							state.tex = texture->GetPixels();
+							state.texwidth = texture->GetWidth();
+							state.texheight = texture->GetHeight();
+							state.texxscale = texture->xScale>>10;
+							state.texyscale = -texture->yScale>>10;
+
+							warped |= texture->bWarped != 0;
+							state.useOptimized = state.texwidth == 64 && state.texheight == 64 && state.texxscale == FRACUNIT>>10 && state.texyscale == -FRACUNIT>>10;
 						}
 					}
 					else
-						tex = NULL;
+						state.tex = NULL;
 				}
 
-				if(tex)
+				if(x == runstart)
+					drawing = state;
+				else if(!state.SameDrawing(drawing))
 				{
-					if(useOptimized)
-					{
-						const int u = (gu>>18) & 63;
-						const int v = (-gv>>18) & 63;
-						const unsigned texoffs = (u * 64) + v;
-						*tex_offset = curshades[tex[texoffs]];
-					}
-					else
-					{
-						const int u = (FixedMul((gu>>8)-512, texxscale)) & (texwidth-1);
-						const int v = (FixedMul((gv>>8)+512, texyscale)) & (texheight-1);
-						const unsigned texoffs = (u * texheight) + v;
-						*tex_offset = curshades[tex[texoffs]];
-					}
+					R_DrawFlatSpan(tex_offset, drawing, curshades, gu, gv, du, dv, drawstart, x);
+					drawstart = x;
+					drawing = state;
 				}
+
+				const unsigned int steps = MIN(R_StepsToNextCell(cu, du), R_StepsToNextCell(cv, dv));
+				if(unsigned(runend - x) <= steps)
+					break;
+				x += steps;
 			}
-			gu += du;
-			gv += dv;
+			R_DrawFlatSpan(tex_offset, drawing, curshades, gu, gv, du, dv, drawstart, runend);
+			runstart = runend;
 		}
 	}
+	return warped;
 }
 
 // Textured Floor and Ceiling by DarkOne
 // With multi-textured floors and ceilings stored in lower and upper bytes of
 // according tile in third mapplane, respectively.
-void DrawFloorAndCeiling(byte *vbuf, unsigned vbufPitch, int min_wallheight)
+bool DrawFloorAndCeiling(byte *vbuf, unsigned vbufPitch, int min_wallheight, const byte *columns)
 {
 	const int halfheight = (viewheight >> 1) - viewshift;
 
-	R_DrawPlane(vbuf, vbufPitch, min_wallheight, halfheight, viewz-(64<<FRACBITS));
-	R_DrawPlane(vbuf, vbufPitch, min_wallheight, halfheight, viewz);
+	const bool warpedFloor = R_DrawPlane(vbuf, vbufPitch, min_wallheight, halfheight, viewz-(64<<FRACBITS), columns);
+	const bool warpedCeiling = R_DrawPlane(vbuf, vbufPitch, min_wallheight, halfheight, viewz, columns);
+	return warpedFloor || warpedCeiling;
 }
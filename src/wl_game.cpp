@@ -31,6 +31,9 @@
 #include "colormatcher.h"
 #include "thingdef/thingdef.h"
 #include "doomerrors.h"
+#include "m_random.h"
+#include "stats.h"
+#include "wl_demo.h"
 
 #ifdef MYPROFILE
 #include <TIME.H>
@@ -417,23 +420,27 @@ void DrawPlayScreen (bool noborder)
 =
 = StartDemoRecord
 =
+= Demos are streamed to a temporary file while recording and renamed once
+= the player picks a demo number.
+=
 ==================
 */
 
-char    demoname[13] = "DEMO?.";
-
-#define MAXDEMOSIZE     8192
+char    demoname[13] = "DEMO?.ECD";
+static const char demotempname[] = "DEMO.TMP";
 
-void StartDemoRecord (int levelnumber)
+static bool StartDemoRecord (const FString &map, int skill)
 {
-	demobuffer=malloc(MAXDEMOSIZE);
-	CHECKMALLOCRESULT(demobuffer);
-	demoptr = (int8_t *) demobuffer;
-	lastdemoptr = demoptr+MAXDEMOSIZE;
+	demowriter = new FDemoWriter();
+	if (!demowriter->Open(demotempname, map, skill, rngseed))
+	{
+		delete demowriter;
+		demowriter = NULL;
+		return false;
+	}
 
-	*demoptr = levelnumber;
-	demoptr += 4;                           // leave space for length
 	demorecord = true;
+	return true;
 }
 
 
@@ -445,34 +452,15 @@ void StartDemoRecord (int levelnumber)
 ==================
 */
 
-static bool CA_WriteFile (const char *filename, void *ptr, int32_t length)
-{
-	const int handle = open(filename, O_CREAT | O_WRONLY | O_BINARY, 777);
-	if (handle == -1)
-		return false;
-
-	if (!write (handle,ptr,length))
-	{
-		close (handle);
-		return false;
-	}
-	close (handle);
-	return true;
-}
-
 void FinishDemoRecord (void)
 {
-	int32_t    length,level;
+	int32_t    level;
 	char str[80];
 
 	demorecord = false;
 
-	length = (int32_t) (demoptr - (int8_t *)demobuffer);
-
-	demoptr = ((int8_t *)demobuffer)+1;
-	demoptr[0] = (int8_t) length;
-	demoptr[1] = (int8_t) (length >> 8);
-	demoptr[2] = 0;
+	delete demowriter;
+	demowriter = NULL;
 
 	VW_FadeIn();
 	US_CenterWindow(24,3);
@@ -486,11 +474,13 @@ void FinishDemoRecord (void)
 		if (level>=0 && level<=9)
 		{
 			demoname[4] = (char)('0'+level);
-			CA_WriteFile (demoname,demobuffer,length);
+			remove (demoname);
+			if (rename (demotempname, demoname) == 0)
+				return;
 		}
 	}
 
-	free(demobuffer);
+	remove (demotempname);
 }
 
 //==========================================================================
@@ -508,35 +498,42 @@ void FinishDemoRecord (void)
 void RecordDemo (void)
 {
 	FString level;
-	int levelnum, esc;
+	int esc;
 	char str[80];
 
 	US_CenterWindow(26,3);
 	PrintY+=6;
-	US_Print(SmallFont, "  Demo which level (#): ");
+	US_Print(SmallFont, "  Demo which level: ");
 	VW_UpdateScreen();
 	VW_FadeIn ();
-	esc = !US_LineInput (SmallFont,px,py,str,NULL,true,2,0,GPalette.WhiteIndex);
+	esc = !US_LineInput (SmallFont,px,py,str,NULL,true,8,0,GPalette.WhiteIndex);
 	if (esc)
 		return;
 
-	levelnum = atoi(str);
-	level.Format("MAP%02d", levelnum);
+	// A plain number is shorthand for MAPxx
+	if (isdigit(str[0]))
+		level.Format("MAP%02d", atoi(str));
+	else
+		level = str;
+	level.ToUpper();
 
 	if (Wads.CheckNumForName(level) == -1)
 		return;
 
 	VW_FadeOut ();
 
+	// Reset the RNG so the demo plays back the same way.
+	FRandom::StaticClearRandom();
+
 	NewGame (gd_hard, level, false);
 
-	StartDemoRecord (levelnum);
+	if (!StartDemoRecord (level, gd_hard))
+		return;
 
 	DrawPlayScreen ();
 	VW_FadeIn ();
 
 	startgame = false;
-	demorecord = true;
 
 	SetupGameLevel ();
 
@@ -565,33 +562,51 @@ void RecordDemo (void)
 =
 = Fades the screen out, then starts a demo.  Exits with the screen unfaded
 =
+= Both the original fixed size demos and extended demos (see wl_demo.h) are
+= accepted.
+=
 ==================
 */
 
-void PlayDemo (int demonumber)
+static void PlayDemoFile (FileReader &file, long length)
 {
-	int length;
-	char demoName[9];
-	sprintf(demoName, "DEMO%d", demonumber);
-	int lumpNum = Wads.GetNumForName(demoName);
-	if(lumpNum == -1)
-		return;
-	FWadLump lump = Wads.OpenLumpNum(lumpNum);
-	demoptr = new int8_t[Wads.LumpLength(lumpNum)];
-	int8_t* demoptr_freeme = demoptr; // Since I can't delete[] demoptr when the time comes.
-	lump.Read(demoptr, Wads.LumpLength(lumpNum));
+	FDemoReader *reader = NULL;
+	int8_t* demoptr_freeme = NULL; // Since I can't delete[] demoptr when the time comes.
 
-	int mapon = *demoptr++;
-	FString level;
-	level.Format("MAP%02d", mapon);
-	NewGame (1,level,false);
-	length = READWORD(*(uint8_t **)&demoptr);
-	// TODO: Seems like the original demo format supports 16 MB demos
-	//       But T_DEM00 and T_DEM01 of Wolf have a 0xd8 as third length size...
-	demoptr++;
-	lastdemoptr = demoptr-4+length;
+	if (FDemoReader::Check(file))
+	{
+		reader = new FDemoReader(file);
+		if (!reader->IsValid() || Wads.CheckNumForName(reader->GetMap()) == -1)
+		{
+			Printf("Could not play demo, unknown version or map.\n");
+			delete reader;
+			return;
+		}
 
-	VW_FadeOut ();
+		rngseed = reader->GetSeed();
+		FRandom::StaticClearRandom();
+		NewGame (reader->GetSkill(), reader->GetMap(), false);
+		demoreader = reader;
+	}
+	else
+	{
+		demoptr = new int8_t[length];
+		demoptr_freeme = demoptr;
+		file.Read(demoptr, length);
+
+		int mapon = *demoptr++;
+		FString level;
+		level.Format("MAP%02d", mapon);
+		NewGame (1,level,false);
+		int demoLength = READWORD(*(uint8_t **)&demoptr);
+		// TODO: Seems like the original demo format supports 16 MB demos
+		//       But T_DEM00 and T_DEM01 of Wolf have a 0xd8 as third length size...
+		demoptr++;
+		lastdemoptr = demoptr-4+demoLength;
+	}
+
+	if (!timedemo)
+		VW_FadeOut ();
 
 	DrawPlayScreen ();
 
@@ -603,6 +618,8 @@ void PlayDemo (int demonumber)
 	PlayLoop ();
 
 	delete[] demoptr_freeme;
+	delete reader;
+	demoreader = NULL;
 
 	demoplayback = false;
 
@@ -610,6 +627,117 @@ void PlayDemo (int demonumber)
 	ClearMemory ();
 }
 
+static void PlayDemoLump (int lumpNum)
+{
+	FWadLump lump = Wads.OpenLumpNum(lumpNum);
+	PlayDemoFile (lump, Wads.LumpLength(lumpNum));
+}
+
+void PlayDemo (int demonumber)
+{
+	char demoName[9];
+	sprintf(demoName, "DEMO%d", demonumber);
+	int lumpNum = Wads.GetNumForName(demoName);
+	if(lumpNum == -1)
+		return;
+
+	PlayDemoLump (lumpNum);
+}
+
+//==========================================================================
+
+/*
+==================
+=
+= TimeDemo
+=
+= Plays a demo back as fast as possible, drawing every tic, and prints how
+= long it took.  The first frame is only used as a reference point so level
+= setup isn't counted.
+=
+==================
+*/
+
+static TArray<float> timeDemoFrames;
+static QWORD timeDemoLastFrame;
+static int32_t timeDemoStartTic;
+
+void TimeDemoFrame (void)
+{
+	const QWORD now = I_ClockNow();
+	if (timeDemoLastFrame == 0)
+		timeDemoStartTic = gamestate.TimeCount;
+	else
+		timeDemoFrames.Push(static_cast<float>((now - timeDemoLastFrame)*PerfToMillisec));
+	timeDemoLastFrame = now;
+}
+
+static int TimeDemoCompare (const void *a, const void *b)
+{
+	const float fa = *static_cast<const float*>(a);
+	const float fb = *static_cast<const float*>(b);
+	return fa < fb ? -1 : (fa > fb ? 1 : 0);
+}
+
+void TimeDemo (const char *demoname)
+{
+	// Demos can be given as a file or a lump name. A number is shorthand
+	// for DEMOn.
+	FileReader file;
+	int lumpNum = -1;
+	FString lumpName;
+	if (!file.Open(demoname))
+	{
+		if (isdigit(demoname[0]))
+			lumpName.Format("DEMO%s", demoname);
+		else
+			lumpName = demoname;
+
+		lumpNum = Wads.CheckNumForName(lumpName);
+		if (lumpNum == -1)
+			Quit ("Could not find demo %s!", lumpName.GetChars());
+	}
+	else
+		lumpName = demoname;
+
+	// Always start from the same seed so runs are comparable. Extended demos
+	// carry their own seed.
+	rngseed = 0;
+	FRandom::StaticClearRandom();
+
+	timeDemoFrames.Clear();
+	timeDemoLastFrame = 0;
+
+	timedemo = true;
+	if (lumpNum == -1)
+		PlayDemoFile (file, file.GetLength());
+	else
+		PlayDemoLump (lumpNum);
+	timedemo = false;
+
+	const unsigned int numFrames = timeDemoFrames.Size();
+	if (numFrames == 0)
+	{
+		printf("Timedemo %s: no frames were rendered.\n", lumpName.GetChars());
+		return;
+	}
+
+	double total = 0;
+	for (unsigned int i = 0;i < numFrames;++i)
+		total += timeDemoFrames[i];
+	qsort(&timeDemoFrames[0], numFrames, sizeof(float), TimeDemoCompare);
+
+	const int32_t numTics = gamestate.TimeCount - timeDemoStartTic;
+	printf("Timedemo %s: %u frames, %d tics in %.3f seconds (%.1f tics/s)\n",
+		lumpName.GetChars(), numFrames, numTics, total/1000, numTics*1000/total);
+
+	static const unsigned int percentiles[] = { 50, 90, 95, 99 };
+	printf("Frame time (ms): avg %.2f  min %.2f", total/numFrames, timeDemoFrames[0]);
+	for (unsigned int i = 0;i < lengthof(percentiles);++i)
+		printf("  %u%% %.2f", percentiles[i], timeDemoFrames[(numFrames-1)*percentiles[i]/100]);
+	printf("  max %.2f\n", timeDemoFrames[numFrames-1]);
+}
+
 //==========================================================================
 
 /*
@@ -969,11 +1097,14 @@ restartgame:
 
 				ClearMemory ();
 
+				// Load the next level's music while the intermission is up.
+				LevelInfo &nextLevel = LevelInfo::Find(next);
+				SD_PrefetchMusic(nextLevel.Music);
+
 				StartTravel ();
 				if(dointermission)
 					LevelCompleted ();              // do the intermission
 
-				LevelInfo &nextLevel = LevelInfo::Find(next);
 				if(nextLevel.Cluster != levelInfo->Cluster)
 					EndText (levelInfo->Cluster, nextLevel.Cluster);
 
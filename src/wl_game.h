@@ -40,6 +40,8 @@ void    DrawPlayScreen (bool noborder=false);
 void    DrawPlayBorderSides (void);
 
 void    PlayDemo (int demonumber);
+void    TimeDemo (const char *demoname);
+void    TimeDemoFrame (void);
 void    RecordDemo (void);
 
 enum
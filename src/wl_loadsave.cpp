@@ -33,6 +33,7 @@
 */
 
 #include <ctime>
+#include <SDL.h>
 #include "config.h"
 #include "c_cvars.h"
 #include "farchive.h"
@@ -155,6 +156,7 @@ public:
 				else
 				{
 					PNGHandle *png;
+					WaitForSave();
 					FILE *file = OpenSaveFile(saveFile.filename, "rb");
 					if(file && (png = M_VerifyPNG(file)))
 					{
@@ -217,6 +219,7 @@ protected:
 		msg.Format(language["DELETESVDGAME"], saveFile.name.GetChars());
 		if(Confirm(msg))
 		{
+			WaitForSave();
 			File(GetFullSaveFileName(saveFile.filename)).remove();
 			item->setVisible(false);
 			setCurrentPosition(getCurrentPosition());
@@ -268,6 +271,8 @@ bool SetupSaveGames()
 	bool canLoad = false;
 	char title[MAX_SAVENAME+1];
 
+	WaitForSave();
+
 	File saveDirectory(FileSys::GetDirectoryPath(FileSys::DIR_Saves));
 	const TArray<FString> &files = saveDirectory.getFileList();
 
@@ -558,8 +563,88 @@ static void Serialize(FArchive &arc)
 
 #define SNAP_ID MAKE_ID('s','n','A','p')
 
+// Once the world has been captured and the screenshot written, the rest of
+// the save (deflating the snapshot and finishing the PNG) happens on a
+// background thread so that the game doesn't hitch.
+struct PendingSave
+{
+	FILE *file;
+	FCompressedMemFile *snapshot;
+	FString filename;
+	bool success;
+	volatile bool finished;
+};
+static PendingSave *pendingSave = NULL;
+static SDL_Thread *saveThread = NULL;
+
+static bool FinishSaveFile(PendingSave *save)
+{
+	bool success = save->snapshot->WritePNGChunk(save->file, SNAP_ID) &&
+		M_FinishPNG(save->file);
+	if(fclose(save->file) != 0)
+		success = false;
+	return success;
+}
+
+static int SaveThreadFunc(void *data)
+{
+	PendingSave *save = static_cast<PendingSave *>(data);
+	save->success = FinishSaveFile(save);
+	save->finished = true;
+	return 0;
+}
+
+static void FinishPendingSave(bool report)
+{
+	if(pendingSave == NULL)
+		return;
+
+	if(saveThread != NULL)
+	{
+		SDL_WaitThread(saveThread, NULL);
+		saveThread = NULL;
+	}
+
+	if(!pendingSave->success)
+	{
+		printf("Could not write %s.\n", GetFullSaveFileName(pendingSave->filename).GetChars());
+		if(report)
+		{
+			Message(language["STR_FAILWRITE"]);
+			IN_ClearKeysDown ();
+			IN_Ack ();
+		}
+	}
+
+	delete pendingSave->snapshot;
+	delete pendingSave;
+	pendingSave = NULL;
+}
+
+static void FinishPendingSaveOnExit()
+{
+	FinishPendingSave(false);
+}
+
+// Blocks until the save in progress, if any, has been written. Anything
+// which reads or removes save files needs to call this first.
+void WaitForSave()
+{
+	FinishPendingSave(true);
+}
+
+// Called every frame so that a failed save is reported as soon as the
+// background write is done.
+void CheckSave()
+{
+	if(pendingSave != NULL && pendingSave->finished)
+		FinishPendingSave(true);
+}
+
 bool Load(const FString &filename)
 {
+	WaitForSave();
+
 	FILE *fileh = OpenSaveFile(filename, "rb");
 	if(fileh == NULL)
 	{
@@ -636,8 +721,12 @@ void SaveScreenshot(FILE *file)
 	NewViewSize(oldviewsize); // Restore
 }
 
+// Returns true once the save has been handed to the save thread. If the
+// write then fails it's reported by CheckSave or the next WaitForSave.
 bool Save(const FString &filename, const FString &title)
 {
+	WaitForSave();
+
 	FILE *fileh = OpenSaveFile(filename, "wb");
 	if(fileh == NULL)
 	{
@@ -655,11 +744,14 @@ bool Save(const FString &filename, const FString &title)
 	SaveProdVersion = SAVEPRODVER;
 
 	// If we get hubs this will need to be moved so that we can have multiple of them
-	FCompressedMemFile snapshot;
-	snapshot.Open();
+	FCompressedMemFile *snapshot = new FCompressedMemFile;
+	snapshot->Open();
 	{
-		FArchive arc(snapshot);
+		FArchive arc(*snapshot);
 		Serialize(arc);
+		// Closing would implode the snapshot here. Leave it uncompressed
+		// for WritePNGChunk on the save thread instead.
+		arc.Detach();
 	}
 
 	SaveScreenshot(fileh);
@@ -705,13 +797,23 @@ bool Save(const FString &filename, const FString &title)
 
 	FRandom::StaticWriteRNGState(fileh);
 
-	{
-		FPNGChunkArchive snapshotArc(fileh, SNAP_ID);
-		snapshot.Serialize(snapshotArc);
-	}
-
-	M_FinishPNG(fileh);
-	fclose(fileh);
+	pendingSave = new PendingSave;
+	pendingSave->file = fileh;
+	pendingSave->snapshot = snapshot;
+	pendingSave->filename = filename;
+	pendingSave->success = false;
+	pendingSave->finished = false;
+
+	atterm(FinishPendingSaveOnExit);
+
+#if SDL_VERSION_ATLEAST(2,0,0)
+	saveThread = SDL_CreateThread(SaveThreadFunc, "SaveGame", pendingSave);
+#else
+	saveThread = SDL_CreateThread(SaveThreadFunc, pendingSave);
+#endif
+	// Without a thread just finish up here.
+	if(saveThread == NULL)
+		SaveThreadFunc(pendingSave);
 	return true;
 }
 
@@ -54,6 +54,8 @@ namespace GameSave
 
 	bool		Load(const FString &filename);
 	bool		Save(const FString &filename, const FString &title);
+	void		WaitForSave();
+	void		CheckSave();
 }
 
 #endif
@@ -24,6 +24,8 @@
 #include "thingdef/thingdef.h"
 #include "v_font.h"
 #include "v_palette.h"
+#include "v_pfx.h"
+#include "stats.h"
 #include "v_video.h"
 #include "r_data/colormaps.h"
 #include "wl_agent.h"
@@ -43,6 +45,8 @@
 #include "colormatcher.h"
 #include "version.h"
 #include "r_2d/r_main.h"
+#include "resourcefiles/huffman.h"
+#include "resourcefiles/wolfmapcommon.h"
 #include "filesys.h"
 #include "g_conversation.h"
 #include "g_intermission.h"
@@ -120,6 +124,9 @@ int     panyadjustment;
 bool param_nowait = false;
 int     param_difficulty = 1;           // default is "normal"
 const char* param_tedlevel = NULL;            // default is not to start a level
+const char* param_timedemo = NULL;
+bool    param_headless = false;         // no window or audio, used for benchmarking
+static bool param_benchdecode = false;
 int     param_joystickindex = 0;
 
 int     param_joystickhat = -1;
@@ -380,7 +387,7 @@ static void InitGame()
 #if SDL_VERSION_ATLEAST(2,0,0)
 	if(SDL_Init(0) < 0)
 #else
-	if(SDL_Init(SDL_INIT_VIDEO) < 0)
+	if(SDL_Init(param_headless ? 0 : SDL_INIT_VIDEO) < 0)
 #endif
 	{
 		printf("Unable to init SDL: %s\n", SDL_GetError());
@@ -388,6 +395,10 @@ static void InitGame()
 	}
 	atterm(SDL_Quit);
 
+	// Frame budgets (GC, netcode) need the clock whether or not the
+	// profiler is on.
+	I_InitClock();
+
 	SDL_ShowCursor(SDL_DISABLE);
 
 	//
@@ -442,7 +453,8 @@ static void InitGame()
 // Fonts
 //
 	VH_Startup ();
-	IN_Startup ();
+	if(!param_headless)
+		IN_Startup ();
 	SD_Startup ();
 	printf("US_Startup: Starting the User Manager.\n");
 	US_Startup ();
@@ -784,6 +796,15 @@ static void NonShareware (void)
 
 static void DemoLoop()
 {
+//
+// benchmark a demo and quit
+//
+	if (param_timedemo)
+	{
+		TimeDemo(param_timedemo);
+		exit(0);
+	}
+
 //
 // check for launch from ted
 //
@@ -1109,6 +1130,16 @@ static const char* CheckParameters(int argc, char *argv[], TArray<FString> &file
 				Net::InitVars.joinAddress = argv[i];
 			}
 		}
+		else IFARG("--netdelay")
+		{
+			if(++i >= argc)
+			{
+				printf("The netdelay option is missing the tics argument!\n");
+				hasError = true;
+			}
+			else
+				Net::InitVars.inputDelay = clamp(atoi(argv[i]), 0, NET_MAXLEAD);
+		}
 		else IFARG("--debugnet")
 		{
 			DebugNetwork = true;
@@ -1117,6 +1148,52 @@ static const char* CheckParameters(int argc, char *argv[], TArray<FString> &file
 		{
 			GameSave::param_foreginsave = true;
 		}
+		else IFARG("--timedemo")
+		{
+			if(++i >= argc)
+			{
+				printf("The timedemo option is missing the demo argument!\n");
+				hasError = true;
+			}
+			else
+			{
+				param_timedemo = argv[i];
+				param_headless = true;
+				param_nowait = true;
+			}
+		}
+		else IFARG("--profile")
+			Profiler::SetOverlay(true);
+		else IFARG("--gcbudget")
+		{
+			if(++i >= argc)
+			{
+				printf("The gcbudget option is missing the time argument!\n");
+				hasError = true;
+			}
+			else
+				GC::PauseTarget = MAX(0, atoi(argv[i]));
+		}
+		else IFARG("--profilecsv")
+		{
+			if(++i >= argc)
+			{
+				printf("The profilecsv option is missing the file argument!\n");
+				hasError = true;
+			}
+			else if(!Profiler::OpenCSV(argv[i]))
+			{
+				printf("Could not open %s for writing!\n", argv[i]);
+				hasError = true;
+			}
+		}
+		else IFARG("--benchpfx")
+		{
+			V_BenchmarkPfx();
+			exit(0);
+		}
+		else IFARG("--benchdecode")
+			param_benchdecode = true;
 		else
 			files.Push(argv[i]);
 	}
@@ -1163,9 +1240,20 @@ static const char* CheckParameters(int argc, char *argv[], TArray<FString> &file
 			" --host <number>        Sets up a network game with the given number of players.\n"
 			" --connect <address>    Connects to the given host.\n"
 			" --port <number>        Port number to use for network communications.\n"
+			" --netdelay <tics>      Runs commands the given number of tics after they are\n"
+			"                        read to hide network latency (host only, max %i)\n"
 			" --debugnet             Enable network debugging messages.\n"
 			" --foreignsave          Disable save game validity checking.\n"
-			, defaultSampleRate
+			" --timedemo <demo>      Plays a demo lump or file as fast as possible without\n"
+			"                        a window or sound and reports the frame times.\n"
+			" --profile              Shows per-frame timing of each render stage.\n"
+			" --profilecsv <file>    Writes per-frame stage timings to a CSV file.\n"
+			" --gcbudget <usec>      Time the garbage collector may take each frame\n"
+			"                        (0 collects as soon as due, default: 1000)\n"
+			" --benchpfx             Benchmarks the palette conversion routines and exits.\n"
+			" --benchdecode          Benchmarks the data decompression routines on the\n"
+			"                        selected game data and exits.\n"
+			, defaultSampleRate, NET_MAXLEAD
 		);
 		exit(1);
 	}
@@ -1295,6 +1383,13 @@ int WL_Main (int argc, char *argv[])
 			language.SetupStrings();
 		}
 
+		if(param_benchdecode)
+		{
+			VGA_BenchmarkHuffman();
+			MAP_BenchmarkPlanes();
+			exit(0);
+		}
+
 		InitThinkerList();
 
 		R_InitRenderer();
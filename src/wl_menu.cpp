@@ -504,6 +504,7 @@ void CreateMenus()
 #if SDL_VERSION_ATLEAST(2,0,0)
 	displayMenu.addItem(new BooleanMenuItem(language["STR_VSYNC"], vid_vsync, ToggleVsync));
 #endif
+	displayMenu.addItem(new BooleanMenuItem(language["STR_INTERPOLATE"], vid_interpolate));
 	displayMenu.addItem(new MultipleChoiceMenuItem(SetAspectRatio, aspectOptions, 6, vid_aspect));
 #ifndef __ANDROID__
 	displayMenu.addItem(new MenuSwitcherMenuItem(language["STR_SELECTRES"], resolutionMenu, EnterResolutionSelection));
@@ -42,12 +42,31 @@
 #include "wl_net.h"
 #include "m_swap.h"
 #include "m_random.h"
+#include "stats.h"
 #include "doomerrors.h"
 #include "zdoomsupport.h"
 #include "zstring.h"
 
 #define NET_DEFAULT_PORT 5029
-#define MAXEXTRATICS 4
+
+// Sent in the connection handshake and bumped whenever a packet changes so
+// that different builds refuse to play together. Builds from before this
+// was added have the player number in its place in the start packet, so it
+// must stay at or above MAXPLAYERS.
+#define NET_VERSION 16
+
+// Number of our own tics kept around to resend until they're acknowledged
+// and the number of tics received from each peer kept for use. With a
+// command lead of N a peer can be N tics ahead of us issuing tics N ahead
+// of its own, so this must be over 2*NET_MAXLEAD+2.
+#define NET_BACKUPTICS 32
+
+// Time in milliseconds to wait for an answer before resending.
+#define NET_RESENDTIME 100
+
+// Longest time in milliseconds to block on the socket before handling
+// input events again.
+#define NET_EVENTTIME 10
 
 namespace Net {
 
@@ -67,6 +86,7 @@ struct RequestPacket
 	enum { Type = NET_REQUEST_CONNECTION };
 
 	BYTE type;
+	BYTE version;
 };
 
 struct StartPacket
@@ -74,8 +94,10 @@ struct StartPacket
 	enum { Type = NET_CONNECTION_START };
 
 	BYTE type;
+	BYTE version;
 	BYTE playerNumber;
 	BYTE numPlayers;
+	BYTE inputDelay;
 	DWORD rngseed;
 	struct Client
 	{
@@ -92,19 +114,42 @@ struct AckPacket
 	int32_t TimeCount;
 };
 
+// Followed by numTics encoded tics starting with firstTic. All of the tics
+// which the recipient hasn't acknowledged are sent, so a lost packet is
+// covered by the next one. Multi-byte fields are little endian.
 struct TicCmdPacket
 {
 	enum { Type = NET_TICCMD };
 
 	BYTE type;
-	int32_t TimeCount;
+	BYTE numTics;
+	BYTE firstTic[4];
+	BYTE ack[4]; // Last tic received in order from the recipient
+};
+#pragma pack()
+
+// Each tic starts with a byte of these flags telling which fields differ
+// from the previous tic in the packet (or from a blank command for the
+// first one). Controls follow as zigzag varints and buttons as bitfields.
+enum
+{
+	TCF_ControlX = 0x01,
+	TCF_ControlY = 0x02,
+	TCF_ControlStrafe = 0x04,
+	TCF_ButtonState = 0x08,
+	TCF_ButtonHeld = 0x10
+};
+
+#define BUTTONBYTES ((NUMBUTTONS+7)/8)
+
+struct NetTicCmd
+{
 	int controlx;
 	int controly;
 	int controlstrafe;
-	bool buttonstate[NUMBUTTONS];
-	bool buttonheld[NUMBUTTONS];
+	BYTE buttonstate[BUTTONBYTES];
+	BYTE buttonheld[BUTTONBYTES];
 };
-#pragma pack()
 
 NetInit InitVars = {
 	MODE_SinglePlayer,
@@ -115,14 +160,26 @@ NetInit InitVars = {
 struct NetClient
 {
 	IPaddress address;
-	TicCmdPacket extratics[MAXEXTRATICS];
-	unsigned short extrapos;
+	NetTicCmd tics[NET_BACKUPTICS];
+	int32_t lastReceived; // Last tic we have from this player in order
+	int32_t lastAcked; // Last of our tics this player has acknowledged
 };
 
 static NetClient Client[MAXPLAYERS];
+static NetTicCmd LocalTics[NET_BACKUPTICS];
+static int32_t NetTic = -1; // Tic being run
+static int32_t IssueTic = -1; // Latest tic we've sent a command for
 static UDPsocket Socket;
+static SDLNet_SocketSet SocketSet;
 static UDPpacket *Packet;
 
+// Wait statistics, windowed over a second of tics.
+static double LastWait, WindowWait, WindowMaxWait, AvgWait, MaxWait;
+static unsigned int LastResends, WindowResends, Resends, TotalResends;
+static unsigned int WindowTics;
+// Fewest tics we had in hand from the slowest peer when a tic came due.
+static int32_t MinBuffered, WindowMinBuffered;
+
 // Just so that we know something is happening do a little animation.
 static const char* const Waiting[4] = {"   ", ".  ", ".. ", "..." };
 
@@ -179,7 +236,11 @@ static void StartHost()
 				Printf("\b\b\b");
 
 				int client = FindClient(Packet->address);
-				if(client == -1)
+				if(data->version != NET_VERSION)
+				{
+					Printf("Ignoring %u.%u.%u.%u:%u, which is running an incompatible version.\n", Packet->address.host&0xFF, (Packet->address.host&0xFF00)>>8, (Packet->address.host&0xFF0000)>>16, (Packet->address.host&0xFF000000)>>24, BigShort(Packet->address.port));
+				}
+				else if(client == -1)
 				{
 					Printf("[%d] New connection from %u.%u.%u.%u:%u!\n", nextclient, Packet->address.host&0xFF, (Packet->address.host&0xFF00)>>8, (Packet->address.host&0xFF0000)>>16, (Packet->address.host&0xFF000000)>>24, BigShort(Packet->address.port));
 					Client[nextclient++].address = Packet->address;
@@ -204,7 +265,9 @@ static void StartHost()
 	StartPacket *startData = (StartPacket *)malloc(startSize);
 	UDPpacket startPacket = { -1, (Uint8*)startData, startSize, startSize, 0 };
 	startData->type = NET_CONNECTION_START;
+	startData->version = NET_VERSION;
 	startData->numPlayers = InitVars.numPlayers;
+	startData->inputDelay = InitVars.inputDelay;
 	startData->rngseed = rngseed;
 	for(unsigned int i = 1;i < InitVars.numPlayers;++i)
 	{
@@ -273,8 +336,8 @@ static void StartJoin()
 	Printf("Attempting to connect to %u.%u.%u.%u:%u :\n   ", address.host&0xFF, (address.host&0xFF00)>>8, (address.host&0xFF0000)>>16, (address.host&0xFF000000)>>24, BigShort(address.port));
 
 	// Send a connection request to host
-	Uint8 requestData[] = {NET_REQUEST_CONNECTION};
-	UDPpacket packet = { -1, requestData, 1, 1, 0, address };
+	Uint8 requestData[] = {NET_REQUEST_CONNECTION, NET_VERSION};
+	UDPpacket packet = { -1, requestData, sizeof(requestData), sizeof(requestData), 0, address };
 
 	for(;;)
 	{
@@ -292,10 +355,13 @@ static void StartJoin()
 		if(SDLNet_UDP_Recv(Socket, Packet))
 		{
 			const StartPacket *data = reinterpret_cast<StartPacket *>(Packet->data);
+			if(Packet->len >= 2 && data->type == StartPacket::Type && data->version != NET_VERSION)
+				throw CFatalError("The host is running an incompatible version.");
 			if(CheckPacketType<StartPacket>(Packet))
 			{
 				ConsolePlayer = data->playerNumber;
 				InitVars.numPlayers = data->numPlayers;
+				InitVars.inputDelay = data->inputDelay;
 				rngseed = data->rngseed;
 
 				Client[0].address = Packet->address;
@@ -322,6 +388,8 @@ static void StartJoin()
 
 static void Shutdown()
 {
+	if(SocketSet)
+		SDLNet_FreeSocketSet(SocketSet);
 	SDLNet_FreePacket(Packet);
 	SDLNet_UDP_Close(Socket);
 }
@@ -344,118 +412,304 @@ void Init()
 		StartHost();
 	else
 		StartJoin();
+
+	// Used to sleep until a packet arrives while waiting for other players.
+	SocketSet = SDLNet_AllocSocketSet(1);
+	if(SocketSet && SDLNet_UDP_AddSocket(SocketSet, Socket) < 0)
+	{
+		SDLNet_FreeSocketSet(SocketSet);
+		SocketSet = NULL;
+	}
 }
 
-void PollControls()
+// Blocks until a packet arrives or the timeout (in milliseconds) expires.
+static void WaitForPacket(Uint32 timeout)
 {
-	bool acked[MAXPLAYERS] = { false };
-	bool controls[MAXPLAYERS] = { false };
-	unsigned int numAcked = 1;
-	unsigned int numControls = 1;
-	acked[ConsolePlayer] = true;
-
-	// We need to send a ticcmd to each player in the game.
-	TicCmdPacket ticcmdData;
-	UDPpacket ticcmdPacket = { -1, (Uint8*)&ticcmdData, sizeof(TicCmdPacket), sizeof(TicCmdPacket), 0 };
-	ticcmdData.type = NET_TICCMD;
-	ticcmdData.TimeCount = gamestate.TimeCount;
-	ticcmdData.controlx = control[ConsolePlayer].controlx;
-	ticcmdData.controly = control[ConsolePlayer].controly;
-	ticcmdData.controlstrafe = control[ConsolePlayer].controlstrafe;
-	memcpy(ticcmdData.buttonstate, control[ConsolePlayer].buttonstate, sizeof(control[ConsolePlayer].buttonstate));
-	memcpy(ticcmdData.buttonheld, control[ConsolePlayer].buttonheld, sizeof(control[ConsolePlayer].buttonheld));
-
-	for(unsigned int i = 0;i < MAXEXTRATICS;++i)
+	if(SocketSet)
+		SDLNet_CheckSockets(SocketSet, timeout);
+	else
+		SDL_Delay(1);
+}
+
+static void RecordWait(double ms, unsigned int resends, int32_t buffered)
+{
+	LastWait = ms;
+	LastResends = resends;
+	TotalResends += resends;
+
+	WindowWait += ms;
+	WindowResends += resends;
+	if(ms > WindowMaxWait)
+		WindowMaxWait = ms;
+	if(buffered < WindowMinBuffered)
+		WindowMinBuffered = buffered;
+	if(++WindowTics >= TICRATE)
 	{
-		for(unsigned int c = 0;c < InitVars.numPlayers;++c)
-		{
-			if(c == ConsolePlayer)
-				continue;
+		AvgWait = WindowWait/WindowTics;
+		MaxWait = WindowMaxWait;
+		MinBuffered = WindowMinBuffered;
+		WindowMinBuffered = InitVars.inputDelay;
+		Resends = WindowResends;
+		WindowWait = WindowMaxWait = 0;
+		WindowResends = WindowTics = 0;
+	}
+}
 
-			if(Client[c].extratics[i].TimeCount == gamestate.TimeCount)
-			{
-				const TicCmdPacket *data = &Client[c].extratics[i];
-
-				if(controls[c])
-					continue;
-				controls[c] = true;
-				++numControls;
-
-				control[c].controlx = data->controlx;
-				control[c].controly = data->controly;
-				control[c].controlstrafe = data->controlstrafe;
-				memcpy(control[c].buttonstate, data->buttonstate, sizeof(control[c].buttonstate));
-				memcpy(control[c].buttonheld, data->buttonheld, sizeof(control[c].buttonheld));
-			}
-		}
+static BYTE *WriteVarInt(BYTE *out, int value)
+{
+	DWORD v = (DWORD(value)<<1) ^ DWORD(value>>31);
+	while(v >= 0x80)
+	{
+		*out++ = BYTE(v|0x80);
+		v >>= 7;
 	}
+	*out++ = BYTE(v);
+	return out;
+}
 
-	// We need to keep an eye out for packets, but we also need to periodically
-	// resend our ticcmd in case it got lost.
-	unsigned int resend = 0;
-	while(numAcked != InitVars.numPlayers || numControls != InitVars.numPlayers)
+static const BYTE *ReadVarInt(const BYTE *in, const BYTE *end, int &value)
+{
+	DWORD v = 0;
+	for(unsigned int shift = 0;shift < 35;shift += 7)
 	{
-		if(resend == 0)
+		if(in == end)
+			return NULL;
+		const BYTE b = *in++;
+		v |= DWORD(b&0x7F)<<shift;
+		if(!(b&0x80))
 		{
-			for(unsigned int i = 0;i < InitVars.numPlayers;++i)
-			{
-				if(acked[i])
-					continue;
+			value = int(v>>1) ^ -int(v&1);
+			return in;
+		}
+	}
+	return NULL;
+}
 
-				ticcmdPacket.address = Client[i].address;
-				SDLNet_UDP_Send(Socket, -1, &ticcmdPacket);
-			}
-			resend = 100;
+static BYTE *EncodeTic(BYTE *out, const NetTicCmd &cmd, const NetTicCmd &base)
+{
+	BYTE &flags = *out++;
+	flags = 0;
+	if(cmd.controlx != base.controlx)
+	{
+		flags |= TCF_ControlX;
+		out = WriteVarInt(out, cmd.controlx);
+	}
+	if(cmd.controly != base.controly)
+	{
+		flags |= TCF_ControlY;
+		out = WriteVarInt(out, cmd.controly);
+	}
+	if(cmd.controlstrafe != base.controlstrafe)
+	{
+		flags |= TCF_ControlStrafe;
+		out = WriteVarInt(out, cmd.controlstrafe);
+	}
+	if(memcmp(cmd.buttonstate, base.buttonstate, BUTTONBYTES) != 0)
+	{
+		flags |= TCF_ButtonState;
+		memcpy(out, cmd.buttonstate, BUTTONBYTES);
+		out += BUTTONBYTES;
+	}
+	if(memcmp(cmd.buttonheld, base.buttonheld, BUTTONBYTES) != 0)
+	{
+		flags |= TCF_ButtonHeld;
+		memcpy(out, cmd.buttonheld, BUTTONBYTES);
+		out += BUTTONBYTES;
+	}
+	return out;
+}
+
+// Decodes a tic on top of cmd, which holds the previous tic in the packet.
+static const BYTE *DecodeTic(const BYTE *in, const BYTE *end, NetTicCmd &cmd)
+{
+	if(in == end)
+		return NULL;
+	const BYTE flags = *in++;
+
+	if((flags & TCF_ControlX) && !(in = ReadVarInt(in, end, cmd.controlx)))
+		return NULL;
+	if((flags & TCF_ControlY) && !(in = ReadVarInt(in, end, cmd.controly)))
+		return NULL;
+	if((flags & TCF_ControlStrafe) && !(in = ReadVarInt(in, end, cmd.controlstrafe)))
+		return NULL;
+	if(flags & TCF_ButtonState)
+	{
+		if(end - in < BUTTONBYTES)
+			return NULL;
+		memcpy(cmd.buttonstate, in, BUTTONBYTES);
+		in += BUTTONBYTES;
+	}
+	if(flags & TCF_ButtonHeld)
+	{
+		if(end - in < BUTTONBYTES)
+			return NULL;
+		memcpy(cmd.buttonheld, in, BUTTONBYTES);
+		in += BUTTONBYTES;
+	}
+	return in;
+}
+
+static void PackButtons(BYTE *bits, const bool *buttons)
+{
+	memset(bits, 0, BUTTONBYTES);
+	for(unsigned int i = 0;i < NUMBUTTONS;++i)
+	{
+		if(buttons[i])
+			bits[i>>3] |= 1<<(i&7);
+	}
+}
+
+static void UnpackButtons(bool *buttons, const BYTE *bits)
+{
+	for(unsigned int i = 0;i < NUMBUTTONS;++i)
+		buttons[i] = (bits[i>>3]>>(i&7))&1;
+}
+
+// Sends all of our tics which the given player hasn't acknowledged yet.
+static void SendTics(unsigned int client)
+{
+	BYTE data[sizeof(TicCmdPacket) + NET_BACKUPTICS*(1 + 3*5 + 2*BUTTONBYTES)];
+	TicCmdPacket *header = reinterpret_cast<TicCmdPacket *>(data);
+
+	const int32_t firstTic = MAX(Client[client].lastAcked+1, IssueTic-(NET_BACKUPTICS-1));
+	header->type = NET_TICCMD;
+	header->numTics = BYTE(IssueTic - firstTic + 1);
+	WriteLittleLong(header->firstTic, firstTic);
+	WriteLittleLong(header->ack, Client[client].lastReceived);
+
+	static const NetTicCmd blank = {0, 0, 0, {0}, {0}};
+	const NetTicCmd *base = &blank;
+	BYTE *out = data + sizeof(TicCmdPacket);
+	for(int32_t tic = firstTic;tic <= IssueTic;++tic)
+	{
+		const NetTicCmd &cmd = LocalTics[tic%NET_BACKUPTICS];
+		out = EncodeTic(out, cmd, *base);
+		base = &cmd;
+	}
+
+	UDPpacket packet = { -1, data, int(out - data), int(out - data), 0, Client[client].address };
+	SDLNet_UDP_Send(Socket, -1, &packet);
+}
+
+// Reads the tics in a packet, keeping the ones which continue the sequence
+// we have from that player.
+static void ReceiveTics(unsigned int client, const UDPpacket *packet)
+{
+	const TicCmdPacket *header = reinterpret_cast<const TicCmdPacket *>(packet->data);
+	const BYTE *in = packet->data + sizeof(TicCmdPacket);
+	const BYTE *end = packet->data + packet->len;
+	NetClient &cl = Client[client];
+
+	const int32_t ack = ReadLittleLong(header->ack);
+	if(ack > cl.lastAcked)
+		cl.lastAcked = ack;
+
+	NetTicCmd cmd = {0, 0, 0, {0}, {0}};
+	int32_t tic = ReadLittleLong(header->firstTic);
+	for(unsigned int i = header->numTics;i-- > 0;++tic)
+	{
+		if(!(in = DecodeTic(in, end, cmd)))
+			break;
+
+		// Anything past the end of the ring would overwrite a tic that
+		// hasn't been run yet. It'll be sent again.
+		if(tic == cl.lastReceived+1 && tic - NetTic < NET_BACKUPTICS)
+		{
+			cl.tics[tic%NET_BACKUPTICS] = cmd;
+			cl.lastReceived = tic;
 		}
+	}
+}
 
-		--resend;
-		SDL_Delay(1);
-		IN_ProcessEvents();
-		while(SDLNet_UDP_Recv(Socket, Packet))
+ADD_STAT(net)
+{
+	FString out;
+	if(InitVars.mode != MODE_SinglePlayer && NetTic >= 0)
+	{
+		out.Format("Net tic %d  Lead: %d  Buffered: %d  Wait: %.2fms  Avg: %.2fms  Max: %.2fms  Resent: %u  %u/s  %u total",
+			NetTic, InitVars.inputDelay, MinBuffered, LastWait, AvgWait, MaxWait, LastResends, Resends, TotalResends);
+	}
+	return out;
+}
+
+void PollControls()
+{
+	// Lockstep: every player sends its command for this tic to everyone
+	// else and doesn't continue until it has everyone's command. There's no
+	// need to wait for acknowledgement since unacknowledged tics go out
+	// again with the next one. While waiting, resend in case the other side
+	// is waiting on us.
+	//
+	// With an input delay the command read now is issued for a tic that
+	// many tics in the future, giving it that much time to reach everyone
+	// before it's needed. Tics which arrive early are held in each peer's
+	// ring until their turn. The first few tics, which nobody issued, are
+	// blank for everyone.
+	if(NetTic < 0)
+	{
+		static const NetTicCmd blank = {0, 0, 0, {0}, {0}};
+		InitVars.inputDelay = MIN<byte>(InitVars.inputDelay, NET_MAXLEAD);
+		for(unsigned int i = 0;i < InitVars.numPlayers;++i)
 		{
-			if(CheckPacketType<TicCmdPacket>(Packet))
-			{
-				// Controls from another player
-				const TicCmdPacket *data = reinterpret_cast<TicCmdPacket *>(Packet->data);
-				int client = FindClient(Packet->address);
+			for(int32_t tic = 0;tic < InitVars.inputDelay;++tic)
+				Client[i].tics[tic] = blank;
+			Client[i].lastReceived = Client[i].lastAcked = InitVars.inputDelay - 1;
+		}
+		for(int32_t tic = 0;tic < InitVars.inputDelay;++tic)
+			LocalTics[tic] = blank;
+		IssueTic = InitVars.inputDelay - 1;
+		MinBuffered = WindowMinBuffered = InitVars.inputDelay;
+	}
+	++NetTic;
+	++IssueTic;
+
+	NetTicCmd &local = LocalTics[IssueTic%NET_BACKUPTICS];
+	local.controlx = control[ConsolePlayer].controlx;
+	local.controly = control[ConsolePlayer].controly;
+	local.controlstrafe = control[ConsolePlayer].controlstrafe;
+	PackButtons(local.buttonstate, control[ConsolePlayer].buttonstate);
+	// What was held is relative to the commands we issue, not the delayed
+	// ones we run.
+	if(InitVars.inputDelay)
+		memcpy(local.buttonheld, LocalTics[(IssueTic-1)%NET_BACKUPTICS].buttonstate, BUTTONBYTES);
+	else
+		PackButtons(local.buttonheld, control[ConsolePlayer].buttonheld);
 
-				if(data->TimeCount != gamestate.TimeCount)
-				{
-					if(data->TimeCount > gamestate.TimeCount)
-					{
-						Client[client].extratics[Client[client].extrapos] = *data;
-						Client[client].extrapos = (Client[client].extrapos+1)%MAXEXTRATICS;
-						SendAck(Packet->address, data->TimeCount);
-					}
-					continue;
-				}
+	// Tics that arrived ahead of time may already have everything we need.
+	unsigned int numWaiting = 0;
+	int32_t buffered = InitVars.inputDelay;
+	for(unsigned int i = 0;i < InitVars.numPlayers;++i)
+	{
+		if(i == ConsolePlayer)
+			continue;
 
-				SendAck(Packet->address, data->TimeCount);
+		SendTics(i);
+		if(Client[i].lastReceived < NetTic)
+			++numWaiting;
+		buffered = MIN(buffered, Client[i].lastReceived - NetTic + 1);
+	}
 
-				if(controls[client])
-					continue;
-				controls[client] = true;
-				++numControls;
+	const QWORD waitStart = I_ClockNow();
+	unsigned int resends = 0;
+	Uint32 resendTime = SDL_GetTicks() + NET_RESENDTIME;
+	while(numWaiting)
+	{
+		const Uint32 now = SDL_GetTicks();
+		WaitForPacket(resendTime > now ? MIN<Uint32>(resendTime - now, NET_EVENTTIME) : 0);
+		IN_ProcessEvents();
+		while(SDLNet_UDP_Recv(Socket, Packet))
+		{
+			const int client = FindClient(Packet->address);
+			if(client < 0 || client == (int)ConsolePlayer)
+				continue;
 
-				control[client].controlx = data->controlx;
-				control[client].controly = data->controly;
-				control[client].controlstrafe = data->controlstrafe;
-				memcpy(control[client].buttonstate, data->buttonstate, sizeof(control[client].buttonstate));
-				memcpy(control[client].buttonheld, data->buttonheld, sizeof(control[client].buttonheld));
-			}
+			if(CheckPacketType<TicCmdPacket>(Packet))
+				ReceiveTics(client, Packet);
 			else if(CheckPacketType<AckPacket>(Packet))
 			{
 				const AckPacket *data = reinterpret_cast<AckPacket *>(Packet->data);
-				if(data->TimeCount != gamestate.TimeCount)
-					continue;
-
-				// Good! A player got our controls.
-				int client = FindClient(Packet->address);
-				if(acked[client])
-					continue;
-
-				acked[FindClient(Packet->address)] = true;
-				++numAcked;
+				if(data->TimeCount > Client[client].lastAcked)
+					Client[client].lastAcked = data->TimeCount;
 			}
 			else if(CheckPacketType<StartPacket>(Packet))
 			{
@@ -463,6 +717,39 @@ void PollControls()
 				SendAck(Client[0].address, 0xFFFFFFFF);
 			}
 		}
+
+		const bool resend = SDL_GetTicks() >= resendTime;
+		numWaiting = 0;
+		for(unsigned int i = 0;i < InitVars.numPlayers;++i)
+		{
+			if(i == ConsolePlayer)
+				continue;
+
+			if(Client[i].lastReceived < NetTic)
+				++numWaiting;
+			if(resend && Client[i].lastAcked < IssueTic)
+			{
+				SendTics(i);
+				++resends;
+			}
+		}
+		if(resend)
+			resendTime = SDL_GetTicks() + NET_RESENDTIME;
+	}
+	RecordWait((I_ClockNow() - waitStart)*PerfToMillisec, resends, MAX<int32_t>(buffered, 0));
+
+	for(unsigned int c = 0;c < InitVars.numPlayers;++c)
+	{
+		if(c == ConsolePlayer && !InitVars.inputDelay)
+			continue;
+
+		const NetTicCmd &cmd = c == ConsolePlayer ?
+			LocalTics[NetTic%NET_BACKUPTICS] : Client[c].tics[NetTic%NET_BACKUPTICS];
+		control[c].controlx = cmd.controlx;
+		control[c].controly = cmd.controly;
+		control[c].controlstrafe = cmd.controlstrafe;
+		UnpackButtons(control[c].buttonstate, cmd.buttonstate);
+		UnpackButtons(control[c].buttonheld, cmd.buttonheld);
 	}
 }
 
@@ -41,6 +41,9 @@
 
 namespace Net {
 
+// Largest number of tics commands may be issued ahead of being run.
+#define NET_MAXLEAD 8
+
 enum Mode
 {
 	MODE_SinglePlayer,
@@ -54,7 +57,7 @@ struct NetInit
 	uint16_t port;
 	byte numPlayers;
 	const char* joinAddress;
-		
+	byte inputDelay; // Tics between reading a command and running it
 };
 
 extern NetInit InitVars;
@@ -21,12 +21,15 @@
 #include "wl_draw.h"
 #include "wl_game.h"
 #include "wl_inter.h"
+#include "wl_loadsave.h"
 #include "wl_net.h"
 #include "wl_play.h"
 #include "g_mapinfo.h"
 #include "a_inventory.h"
 #include "am_map.h"
 #include "wl_iwad.h"
+#include "stats.h"
+#include "wl_demo.h"
 
 /*
 =============================================================================
@@ -152,9 +155,10 @@ void ControlScheme::setMouse(ControlScheme* scheme, Button button, int value)
 
 int viewsize;
 
-bool demorecord, demoplayback;
+bool demorecord, demoplayback, timedemo;
 int8_t *demoptr, *lastdemoptr;
-memptr demobuffer;
+FDemoReader *demoreader;
+FDemoWriter *demowriter;
 
 //
 // current user input
@@ -435,6 +439,13 @@ void PollControls (bool absolutes)
 
 	if (demoplayback)
 	{
+		if (demoreader)
+		{
+			if (!demoreader->ReadTic(cmd))
+				playstate = ex_completed;   // demo is done
+			return;
+		}
+
 		//
 		// read commands from demo buffer
 		//
@@ -485,24 +496,9 @@ void PollControls (bool absolutes)
 	if (demorecord)
 	{
 		//
-		// save info out to demo buffer
+		// save info out to demo file
 		//
-		buttonbits = 0;
-
-		// TODO: Support 32-bit buttonbits
-		for (i = NUMBUTTONS - 1; i >= 0; i--)
-		{
-			buttonbits <<= 1;
-			if (cmd.buttonstate[i])
-				buttonbits |= 1;
-		}
-
-		*demoptr++ = buttonbits;
-		*demoptr++ = cmd.controlx;
-		*demoptr++ = cmd.controly;
-
-		if (demoptr >= lastdemoptr - 8)
-			playstate = ex_completed;
+		demowriter->WriteTic(cmd);
 	}
 	else if(Net::InitVars.mode != Net::MODE_SinglePlayer)
 		Net::PollControls();
@@ -526,7 +522,14 @@ void ProcessEvents()
 //
 // get timing info for last frame
 //
-	if (demoplayback || demorecord)   // demo recording and playback needs to be constant
+	if (timedemo)
+	{
+		// Run as fast as possible, drawing every tic. The time count is
+		// advanced by hand so animations don't depend on the host speed.
+		lasttimecount += 1;
+		tics = 1;
+	}
+	else if (demoplayback || demorecord)   // demo recording and playback needs to be constant
 	{
 		// wait up to DEMOTICS Wolf tics
 		uint32_t curtime = SDL_GetTicks();
@@ -540,6 +543,9 @@ void ProcessEvents()
 
 		tics = DEMOTICS;
 	}
+	// Draw as often as we can, running tics as they come due.
+	else if (vid_interpolate && !noadaptive)
+		CalcFrameTics ();
 	else
 		CalcTics ();
 }
@@ -1025,6 +1031,8 @@ void PlayLoop (void)
 		IN_StartAck ();
 
 	StatusBar->NewGame();
+	Profiler::Resync();
+	R_SaveCameraPosition();
 
 	do
 	{
@@ -1041,17 +1049,25 @@ void PlayLoop (void)
 			static bool absolutes = false;
 
 			// If paused due to the automap, continue polling controls but don't tick anything.
-			PollControls(absolutes);
+			// Frames drawn in between tics don't poll.
+			if(tics)
+			{
+				R_SaveCameraPosition();
+				PollControls(absolutes);
 
-			absolutes = !absolutes;
+				absolutes = !absolutes;
+			}
 		}
 		else
 		{
 			for (unsigned int i = 0;i < tics;++i)
 			{
 				PollControls(!i);
+				R_SaveCameraPosition();
 
 				++gamestate.TimeCount;
+
+				FProfileScope profile(PROF_Thinkers);
 				thinkerList->Tick();
 				AActor::FinishSpawningActors();
 			}
@@ -1070,21 +1086,35 @@ void PlayLoop (void)
 		funnyticount += tics;
 
 		TexMan.UpdateAnimations(lasttimecount*14);
-		GC::CheckGC();
+		{
+			FProfileScope profile(PROF_GC);
+			GC::FrameStep();
+		}
 
 		UpdateSoundLoc ();      // JAB
 		if (screenfaded)
 			VW_FadeIn ();
 
 		CheckKeys ();
+		GameSave::CheckSave();
 		if (!loadedgame)
 		{
-			StatusBar->Tick();
+			FProfileScope profile(PROF_StatusBar);
+			// Interpolated frames don't advance the game, so don't let
+			// them advance the status bar either.
+			if (tics)
+				StatusBar->Tick();
 			if ((gamestate.TimeCount & 1) || !(tics & 1))
 				StatusBar->DrawStatusBar();
 		}
 
-		VH_UpdateScreen();
+		{
+			FProfileScope profile(PROF_Present);
+			VH_UpdateScreen();
+		}
+		Profiler::EndFrame();
+		if (timedemo)
+			TimeDemoFrame ();
 //
 // debug aids
 //
@@ -37,9 +37,10 @@ extern  bool        madenoise;
 extern  int         godmode;
 extern	bool		notargetmode;
 
-extern  bool        demorecord,demoplayback;
+extern  bool        demorecord,demoplayback,timedemo;
 extern  int8_t      *demoptr, *lastdemoptr;
-extern  memptr      demobuffer;
+extern  class FDemoReader *demoreader;
+extern  class FDemoWriter *demowriter;
 
 void    PlayLoop (void);
 
@@ -27,4 +27,11 @@ extern fixed gLevelVisibility;
 extern fixed gLevelMaxLightVis;
 extern int gLevelLight;
 
+// Colormaps for the current light level and visibility, looked up by
+// projected height for walls and sprites or by row for the flats. The
+// tables are rebuilt by R_SetupLighting only when their inputs change.
+void R_SetupLighting();
+const BYTE *R_DepthColormap(int height);
+const BYTE * const *R_FlatColormaps(unsigned int slot, fixed planeheight, unsigned int rows);
+
 #endif